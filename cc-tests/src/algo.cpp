@@ -0,0 +1,253 @@
+#include "cc/test.hpp"
+#include "cc/algo.hpp"
+#include "cc/arr.hpp"
+#include "cc/fmt.hpp"
+
+namespace {
+  struct Random {
+    u64 state = 0x9e3779b97f4a7c15ull;
+
+    u64 next() {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+    }
+  };
+
+  struct Record {
+    u32 key;
+    u32 order;
+  };
+
+  enum class Pattern {
+    Random,
+    FewUnique,
+    Sorted,
+    Reversed,
+    SawTooth,
+  };
+
+  Arr<s64> make_input(Pattern pattern, size_t count) {
+    Random   random;
+    Arr<s64> arr(count);
+    for (size_t i = 0; i < count; ++i) {
+      switch (pattern) {
+        case Pattern::Random:
+          arr[i] = s64(random.next());
+          break;
+        case Pattern::FewUnique:
+          arr[i] = s64(random.next() % 4);
+          break;
+        case Pattern::Sorted:
+          arr[i] = s64(i);
+          break;
+        case Pattern::Reversed:
+          arr[i] = s64(count - i);
+          break;
+        case Pattern::SawTooth:
+          arr[i] = s64(i % 64);
+          break;
+      }
+    }
+    return arr;
+  }
+
+  bool is_sorted(ArrView<s64> arr) {
+    for (size_t i = 1; i < arr.size(); ++i) {
+      if (arr[i] < arr[i - 1]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool same_sum(ArrView<s64> a, ArrView<s64> b) {
+    u64 sum_a = 0;
+    u64 sum_b = 0;
+    u64 xor_a = 0;
+    u64 xor_b = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+      sum_a += u64(a[i]);
+      sum_b += u64(b[i]);
+      xor_a ^= u64(a[i]);
+      xor_b ^= u64(b[i]);
+    }
+    return a.size() == b.size() && sum_a == sum_b && xor_a == xor_b;
+  }
+
+  constexpr Pattern g_patterns[] = {Pattern::Random, Pattern::FewUnique, Pattern::Sorted,
+                                    Pattern::Reversed, Pattern::SawTooth};
+  constexpr size_t  g_sizes[]    = {0, 1, 2, 3, 23, 24, 25, 100, 129, 1000, 5000};
+}  // namespace
+
+mTestCase(algo_sort_patterns) {
+  for (auto pattern : g_patterns) {
+    for (auto size : g_sizes) {
+      auto input = make_input(pattern, size);
+
+      auto sorted = input;
+      sort(sorted, [](const s64& a, const s64& b) { return a < b; });
+      mRequire(is_sorted(sorted));
+      mRequire(same_sum(sorted, input));
+
+      auto radix = input;
+      radix_sort(ArrView<s64>(radix));
+      mRequire(radix == sorted);
+
+      auto defaulted = input;
+      sort(ArrView<s64>(defaulted));
+      mRequire(defaulted == sorted);
+
+      auto stable = input;
+      stable_sort(ArrView<s64>(stable));
+      mRequire(stable == sorted);
+
+      auto heap = input;
+      partial_sort(ArrView<s64>(heap), size);
+      mRequire(heap == sorted);
+    }
+  }
+}
+
+mTestCase(algo_sort_str) {
+  Arr<Str> strs;
+  Random   random;
+  for (size_t i = 0; i < 500; ++i) {
+    strs.push(fmt(random.next() % 1000));
+  }
+  sort(ArrView<Str>(strs));
+  for (size_t i = 1; i < strs.size(); ++i) {
+    mRequire(strs[i - 1].compare(strs[i]) != ComparePos::Greater);
+  }
+}
+
+mTestCase(algo_stable_sort) {
+  Arr<Record> records;
+  Random      random;
+  for (u32 i = 0; i < 3000; ++i) {
+    records.push({u32(random.next() % 16), i});
+  }
+  auto by_key = [](const Record& a, const Record& b) { return a.key < b.key; };
+
+  auto merged = records;
+  stable_sort(ArrView<Record>(merged), by_key);
+  for (size_t i = 1; i < merged.size(); ++i) {
+    mRequire(merged[i - 1].key <= merged[i].key);
+    if (merged[i - 1].key == merged[i].key) {
+      mRequire(merged[i - 1].order < merged[i].order);
+    }
+  }
+
+  // radix sort is stable too
+  auto radix = records;
+  radix_sort(ArrView<Record>(radix), [](const Record& r) { return r.key; });
+  for (size_t i = 0; i < radix.size(); ++i) {
+    mRequire(radix[i].key == merged[i].key);
+    mRequire(radix[i].order == merged[i].order);
+  }
+}
+
+mTestCase(algo_radix_sort_keys) {
+  s32 ints[]     = {5, -1, INT_MIN, 0, INT_MAX, -100, 7};
+  s32 expected[] = {INT_MIN, -100, -1, 0, 5, 7, INT_MAX};
+  radix_sort(ArrView(ints));
+  mRequire(ArrView(ints) == ArrView(expected));
+
+  u8 bytes[]          = {200, 3, 255, 0, 3};
+  u8 expected_bytes[] = {0, 3, 3, 200, 255};
+  radix_sort(ArrView(bytes));
+  mRequire(ArrView(bytes) == ArrView(expected_bytes));
+
+  StrHash hashes[] = {"c"_sh, "a"_sh, "b"_sh, "a"_sh};
+  radix_sort(ArrView(hashes));
+  for (size_t i = 1; i < mArrSize(hashes); ++i) {
+    mRequire(!(hashes[i] < hashes[i - 1]));
+  }
+}
+
+mTestCase(algo_partial_sort) {
+  for (auto pattern : g_patterns) {
+    auto input  = make_input(pattern, 1000);
+    auto sorted = input;
+    sort(ArrView<s64>(sorted));
+
+    for (size_t count : {size_t(0), size_t(1), size_t(10), size_t(999)}) {
+      auto partial = input;
+      partial_sort(ArrView<s64>(partial), count);
+      mRequire(partial.sub(0, count) == sorted.sub(0, count));
+      mRequire(same_sum(partial, input));
+    }
+  }
+}
+
+mTestCase(algo_nth_element) {
+  for (auto pattern : g_patterns) {
+    for (auto size : g_sizes) {
+      if (size == 0) {
+        continue;
+      }
+      auto input  = make_input(pattern, size);
+      auto sorted = input;
+      sort(ArrView<s64>(sorted));
+
+      for (size_t nth : {size_t(0), size / 2, size - 1}) {
+        auto arr = input;
+        nth_element(ArrView<s64>(arr), nth);
+        mRequire(arr[nth] == sorted[nth]);
+        for (size_t i = 0; i < nth; ++i) {
+          mRequire(arr[i] <= arr[nth]);
+        }
+        for (size_t i = nth + 1; i < size; ++i) {
+          mRequire(arr[i] >= arr[nth]);
+        }
+      }
+    }
+  }
+}
+
+mBenchCase(bench_sort) {
+  constexpr size_t count = 200'000;
+
+  struct {
+    Pattern pattern;
+    StrView name;
+  } inputs[] = {
+      {Pattern::Random, "random"_sv},
+      {Pattern::Sorted, "sorted"_sv},
+      {Pattern::Reversed, "reversed"_sv},
+      {Pattern::FewUnique, "few unique"_sv},
+  };
+
+  auto less = [](const s64& a, const s64& b) { return a < b; };
+
+  for (const auto& [pattern, name] : inputs) {
+    auto input = make_input(pattern, count);
+
+    auto arr   = input;
+    auto begin = Time::now();
+    sort(ArrView<s64>(arr), less);
+    bench_report(fmt("pdq sort, ", name), count, Time::now() - begin);
+
+    arr   = input;
+    begin = Time::now();
+    stable_sort(ArrView<s64>(arr), less);
+    bench_report(fmt("stable sort, ", name), count, Time::now() - begin);
+
+    arr   = input;
+    begin = Time::now();
+    radix_sort(ArrView<s64>(arr));
+    bench_report(fmt("radix sort, ", name), count, Time::now() - begin);
+
+    arr   = input;
+    begin = Time::now();
+    partial_sort(ArrView<s64>(arr), count / 100, less);
+    bench_report(fmt("partial sort 1%, ", name), count, Time::now() - begin);
+
+    arr   = input;
+    begin = Time::now();
+    nth_element(ArrView<s64>(arr), count / 2, less);
+    bench_report(fmt("nth element, ", name), count, Time::now() - begin);
+    bench_keep(arr[count / 2]);
+  }
+}
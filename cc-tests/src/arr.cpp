@@ -2,6 +2,8 @@
 #include "cc/arr.hpp"
 #include "cc/str.hpp"
 #include "cc/algo.hpp"
+#include "cc/fmt.hpp"
+#include "cc/error.hpp"
 
 namespace {
   class TestClass {
@@ -20,6 +22,38 @@ namespace {
       is_special_constructed = true;
     }
   };
+
+  class NoDefaultCtor {
+    int value_;
+
+   public:
+    explicit NoDefaultCtor(int value) : value_(value) {}
+    int value() const { return value_; }
+  };
+
+  struct LifetimeCounter {
+    static inline int alive = 0;
+
+    int value = 0;
+
+    LifetimeCounter() { ++alive; }
+    explicit LifetimeCounter(int v) : value(v) { ++alive; }
+    LifetimeCounter(const LifetimeCounter& o) : value(o.value) { ++alive; }
+    LifetimeCounter(LifetimeCounter&& o) noexcept : value(o.value) { ++alive; }
+    LifetimeCounter& operator=(const LifetimeCounter&) = default;
+    LifetimeCounter& operator=(LifetimeCounter&&)      = default;
+    ~LifetimeCounter() { --alive; }
+  };
+
+  struct ThrowingCtor {
+    int value = 0;
+
+    explicit ThrowingCtor(int v) : value(v) {
+      if (v < 0) {
+        throw Err("negative value"_s);
+      }
+    }
+  };
 }  // namespace
 
 mTestCase(arr_default_ctor) {
@@ -170,6 +204,194 @@ mTestCase(arr_resize_zero) {
   mRequire(arr.data() != nullptr);
 }
 
+mTestCase(arr_capacity) {
+  Arr<int> arr;
+  mRequire(arr.capacity() == 0);
+
+  arr.reserve(16);
+  mRequire(arr.capacity() == 16);
+  mRequire(arr.size() == 0);
+  auto* reserved = arr.data();
+
+  for (int i = 0; i < 16; ++i) {
+    arr.push(i);
+  }
+  mRequire(arr.size() == 16);
+  mRequire(arr.data() == reserved);  // no reallocation within capacity
+
+  arr.push(16);
+  mRequire(arr.size() == 17);
+  mRequire(arr.capacity() >= 32);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i] == (int)i);
+  }
+
+  arr.resize(4);
+  mRequire(arr.size() == 4);
+  mRequire(arr.capacity() >= 32);
+
+  arr.shrink_to_fit();
+  mRequire(arr.size() == 4);
+  mRequire(arr.capacity() == 4);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i] == (int)i);
+  }
+
+  arr.resize(0);
+  arr.shrink_to_fit();
+  mRequire(arr.capacity() == 0);
+  mRequire(arr.data() == nullptr);
+}
+
+mTestCase(arr_push_complex) {
+  Arr<Str> arr;
+  for (int i = 0; i < 100; ++i) {
+    arr.push(fmt(i));
+  }
+  mRequire(arr.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    mRequire(arr[size_t(i)] == fmt(i));
+  }
+
+  arr.resize(10);
+  arr.resize(20);
+  for (size_t i = 10; i < arr.size(); ++i) {
+    mRequire(arr[i].empty());
+  }
+}
+
+mTestCase(arr_emplace) {
+  Arr<TestClass> arr;
+  auto&          v = arr.emplace(1, 2);
+  mRequire(v.is_special_constructed);
+  arr.emplace();
+  mRequire(arr.size() == 2);
+  mRequire(arr[0].is_special_constructed);
+  mRequire(arr[1].is_default_constructed);
+
+  Arr<Str> strs;
+  strs.emplace("abc", 2);
+  mRequire(strs[0] == "ab");
+}
+
+mTestCase(arr_emplace_throws) {
+  Arr<ThrowingCtor> arr;
+  arr.emplace(1);
+  while (arr.size() < arr.capacity()) {
+    arr.emplace(int(arr.size()) + 1);
+  }
+  size_t capacity = arr.capacity();
+
+  // slow path: grown buffer is released when constructor throws (checked by asan)
+  bool thrown = false;
+  try {
+    arr.emplace(-1);
+  } catch (const Err&) {
+    thrown = true;
+  }
+  mRequire(thrown);
+  mRequire(arr.size() == capacity && arr.capacity() == capacity);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i].value == int(i) + 1);
+  }
+}
+
+mTestCase(arr_append) {
+  int      values[] = {1, 2, 3};
+  Arr<int> arr;
+  arr.append(ArrView(values));
+  arr.append(ArrView(values));
+  mRequire(arr.size() == 6);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i] == (int)(i % 3) + 1);
+  }
+
+  // self append should survive reallocation
+  arr.shrink_to_fit();
+  arr.append(arr);
+  mRequire(arr.size() == 12);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i] == (int)(i % 3) + 1);
+  }
+
+  Arr<Str> strs{Str("a"), Str("b")};
+  Arr<Str> other{Str("c")};
+  strs += other;
+  mRequire(strs.size() == 3);
+  mRequire(strs[2] == "c");
+  mRequire(other[0] == "c");
+}
+
+mTestCase(arr_no_default_ctor) {
+  Arr<NoDefaultCtor> arr;
+  for (int i = 0; i < 10; ++i) {
+    arr.emplace(i);
+  }
+  arr.push(NoDefaultCtor(10));
+  mRequire(arr.size() == 11);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    mRequire(arr[i].value() == (int)i);
+  }
+
+  Arr<NoDefaultCtor> copy(arr);
+  mRequire(copy.size() == 11);
+  mRequire(copy[10].value() == 10);
+}
+
+mTestCase(arr_lifetime) {
+  {
+    Arr<LifetimeCounter> arr;
+    for (int i = 0; i < 100; ++i) {
+      arr.emplace(i);
+    }
+    mRequire(LifetimeCounter::alive == 100);
+
+    arr.resize(10);
+    mRequire(LifetimeCounter::alive == 10);
+
+    arr.resize(20);
+    mRequire(LifetimeCounter::alive == 20);
+
+    arr.emplace(arr[0]);  // reference into own storage at full capacity
+    mRequire(arr[20].value == 0);
+    mRequire(LifetimeCounter::alive == 21);
+
+    Arr<LifetimeCounter> copy = arr;
+    mRequire(LifetimeCounter::alive == 42);
+
+    copy = ArrView(arr).sub(0, 5);
+    mRequire(LifetimeCounter::alive == 26);
+
+    arr.shrink_to_fit();
+    mRequire(LifetimeCounter::alive == 26);
+  }
+  mRequire(LifetimeCounter::alive == 0);
+}
+
+mTestCase(arr_relocate) {
+  static_assert(is_trivially_relocatable<Str>);
+  static_assert(is_trivially_relocatable<UPtr<int>>);
+  static_assert(is_trivially_relocatable<Arr<Str>>);
+  static_assert(!is_trivially_relocatable<LifetimeCounter>);
+
+  Arr<UPtr<int>> ptrs;
+  for (int i = 0; i < 100; ++i) {
+    ptrs.push(UPtr<int>(new int(i)));
+  }
+  for (size_t i = 0; i < ptrs.size(); ++i) {
+    mRequire(*ptrs[i] == (int)i);
+  }
+
+  Arr<Str> strs;
+  for (int i = 0; i < 100; ++i) {
+    strs.push(fmt(i));
+  }
+  strs.shrink_to_fit();
+  for (size_t i = 0; i < strs.size(); ++i) {
+    mRequire(strs[i] == fmt(i));
+  }
+}
+
 mTestCase(arr_for_loop) {
   Arr<int> arr(8);
   for (auto& v : arr) {
@@ -298,3 +520,25 @@ mTestCase(ptr_intersection) {
   mRequire(ptr_intersects((void*)300, 20, (void*)310, 200));
   mRequire(!ptr_intersects((void*)300, 20, (void*)400, 200));
 }
+
+mBenchCase(bench_arr_push) {
+  for (size_t count : {size_t(1'000), size_t(10'000), size_t(100'000), size_t(1'000'000)}) {
+    Arr<u64> arr;
+    auto     begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      arr.push(i);
+    }
+    bench_keep(arr.data());
+    bench_report(fmt("push u64 x", count), count, Time::now() - begin);
+  }
+
+  for (size_t count : {size_t(1'000), size_t(10'000), size_t(100'000)}) {
+    Arr<Str> arr;
+    auto     begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      arr.push(Str("value"));
+    }
+    bench_keep(arr.data());
+    bench_report(fmt("push Str x", count), count, Time::now() - begin);
+  }
+}
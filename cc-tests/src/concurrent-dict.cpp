@@ -0,0 +1,109 @@
+#include "cc/test.hpp"
+#include "cc/concurrent-dict.hpp"
+#include "cc/parallel.hpp"
+#include "cc/str.hpp"
+#include "cc/fmt.hpp"
+
+mTestCase(concurrent_dict_basic) {
+  ConcurrentDict<Str, int, 4> di;
+  di.insert(Str("a"), 1);
+  di.insert(Str("b"), 2);
+  di.insert(Str("a"), 3);
+
+  int value = 0;
+  mRequire(di.find("a"_sv, [&](const int& v) { value = v; }));
+  mRequire(value == 3);
+  mRequire(!di.find("c"_sv, [&](const int&) { value = -1; }));
+  mRequire(value == 3);
+
+  mRequire(di.update(Str("b"), [](int& v) { v *= 10; }));
+  mRequire(di.find("b"_sv, [&](const int& v) { value = v; }));
+  mRequire(value == 20);
+
+  di.upsert(Str("c"), [](int& v) { v += 5; });
+  di.upsert(Str("c"), [](int& v) { v += 5; });
+  mRequire(di.find("c"_sv, [&](const int& v) { value = v; }));
+  mRequire(value == 10);
+
+  mRequire(di.size() == 3);
+  mRequire(di.erase("a"_sv));
+  mRequire(!di.erase("a"_sv));
+  mRequire(!di.contains("a"_sv));
+  mRequire(di.contains("b"_sv));
+
+  size_t shards = 0;
+  size_t keys   = 0;
+  di.for_each_shard([&](Dict<Str, int>& shard) {
+    shards++;
+    keys += shard.size();
+  });
+  mRequire(shards == 4);
+  mRequire(keys == 2);
+
+  di.clear();
+  mRequire(di.size() == 0);
+}
+
+mTestCase(concurrent_dict_threads) {
+  constexpr size_t count = 20'000;
+
+  ConcurrentDict<u64, u64> di;
+  parallel_for(0, count, [&](size_t i) {
+    di.insert(u64(i), u64(i * 2));
+    di.upsert(u64(i % 64), [](u64& v) { v++; });
+  });
+  mRequire(di.size() == count);
+
+  AtomicInt missing = 0;
+  AtomicInt wrong   = 0;
+  parallel_for(0, count, [&](size_t i) {
+    auto check = [&](const u64& v) {
+      if (i >= 64 && v != i * 2) {
+        ++wrong;
+      }
+    };
+    if (!di.find(u64(i), check)) {
+      ++missing;
+    }
+    if (i % 2 == 0) {
+      di.erase(u64(i));
+    }
+  });
+  mRequire(missing.load() == 0);
+  mRequire(wrong.load() == 0);
+  mRequire(di.size() == count / 2);
+}
+
+mBenchCase(bench_concurrent_dict) {
+  constexpr size_t count = 1'000'000;
+  constexpr size_t keys  = 100'000;
+
+  {
+    Mutex          mutex;
+    Dict<u64, u64> di;
+    auto           begin = Time::now();
+    parallel_for(0, count, [&](size_t i) {
+      LockGuard lock{mutex};
+      if (i % 8 == 0) {
+        di.insert(u64(i % keys), u64(i));
+      } else {
+        auto it = di.find(u64(i % keys));
+        bench_keep(it ? it.value() : 0);
+      }
+    });
+    bench_report("dict + mutex, 1/8 writes"_sv, count, Time::now() - begin);
+  }
+
+  {
+    ConcurrentDict<u64, u64> di;
+    auto                     begin = Time::now();
+    parallel_for(0, count, [&](size_t i) {
+      if (i % 8 == 0) {
+        di.insert(u64(i % keys), u64(i));
+      } else {
+        di.find(u64(i % keys), [](const u64& value) { bench_keep(value); });
+      }
+    });
+    bench_report("concurrent dict, 1/8 writes"_sv, count, Time::now() - begin);
+  }
+}
@@ -2,6 +2,8 @@
 #include "cc/dict.hpp"
 #include "cc/str.hpp"
 #include "cc/fmt.hpp"
+#include "cc/arr.hpp"
+#include "cc/time.hpp"
 
 namespace {
   struct CustomKey {
@@ -213,3 +215,232 @@ mTestCase(dict_str_stress) {
     mRequire(other2.find(key).value() == val);
   }
 }
+
+mTestCase(dict_lookup_key) {
+  Dict<Str, int> di;
+  di.insert(Str("one"), 1);
+  di.insert(Str("two"), 2);
+
+  StrView one = "one"_sv;
+  mRequire(di.find(one) != di.end());
+  mRequire(di.find(one).value() == 1);
+  mRequire(di.contains(one));
+  mRequire(!di.contains("three"_sv));
+  mRequire(di.contains(Str("two")));
+
+  auto [it, inserted] = di.try_emplace("three"_sv, 3);
+  mRequire(inserted);
+  mRequire(it.key() == "three"_sv);
+  mRequire(it.value() == 3);
+
+  auto [existing, inserted_again] = di.try_emplace(Str("three"), 4);
+  mRequire(!inserted_again);
+  mRequire(existing.value() == 3);
+
+  di.get_or_insert("four"_sv) += 4;
+  di.get_or_insert("four"_sv) += 4;
+  mRequire(di.find("four"_sv).value() == 8);
+  mRequire(di.get_or_insert(Str("one")) == 1);
+  mRequire(di.size() == 4);
+
+  mRequire(di.erase("two"_sv));
+  mRequire(!di.erase("two"_sv));
+  mRequire(!di.contains("two"_sv));
+  mRequire(di.size() == 3);
+
+  VDict<Str, int> vdi;
+  vdi.insert(Str("one"), 1);
+  mRequire(vdi.find(one).value() == 1);
+  mRequire(vdi.contains(one));
+  mRequire(!vdi.contains("two"_sv));
+  mRequire(vdi.erase(one));
+  mRequire(vdi.size() == 0);
+}
+
+mTestCase(dict_build_from) {
+  Arr<Pair<Str, int>> pairs;
+  for (int i = 0; i < 1000; i++) {
+    pairs.push({fmt(i), i});
+  }
+  pairs.push({Str("7"), -7});
+
+  auto di = Dict<Str, int>::build_from(pairs);
+  mRequire(di.size() == 1000);
+  mRequire(di.find("7"_sv).value() == -7);
+  mRequire(di.find("999"_sv).value() == 999);
+
+  Arr<Str>  keys;
+  Arr<int*> values(2000);
+  for (int i = 0; i < 2000; i++) {
+    keys.push(fmt(i));
+  }
+  di.find_batch(keys, values);
+  for (int i = 0; i < 2000; i++) {
+    if (i < 1000) {
+      mRequire(values[i] == &di.find(keys[i]).value());
+    } else {
+      mRequire(values[i] == nullptr);
+    }
+  }
+
+  Dict<Str, int> empty;
+  empty.find_batch(ArrView<Str>(keys).sub(0, 3), ArrView<int*>(values).sub(0, 3));
+  mRequire(values[0] == nullptr && values[2] == nullptr);
+}
+
+namespace {
+  u64 next_random(u64& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  template <typename TDict>
+  u64 sum_values(TDict& di) {
+    u64 sum = 0;
+    for (auto it = di.begin(); it != di.end(); ++it) {
+      sum += it.key() ^ it.value();
+    }
+    return sum;
+  }
+}  // namespace
+
+mTestCase(dict_type_erased_matches) {
+  Dict<u64, u64>  di;
+  VDict<u64, u64> vdi;
+  u64             state = 0x9e3779b97f4a7c15ull;
+
+  for (int i = 0; i < 20'000; i++) {
+    u64 key = next_random(state) % 4096;
+    switch (next_random(state) % 3) {
+      case 0:
+      case 1: {
+        mRequire(di.insert(u64(key), u64(i)).value() == u64(i));
+        mRequire(vdi.insert(u64(key), u64(i)).value() == u64(i));
+        break;
+      }
+      case 2: {
+        mRequire(di.erase(key) == vdi.erase(key));
+        break;
+      }
+    }
+    mRequire(di.size() == vdi.size());
+  }
+
+  for (u64 key = 0; key < 4096; key++) {
+    auto it  = di.find(key);
+    auto vit = vdi.find(key);
+    mRequire(bool(it) == bool(vit));
+    if (it) {
+      mRequire(it.value() == vit.value());
+    }
+  }
+  mRequire(sum_values(di) == sum_values(vdi));
+
+  Arr<u64> even_keys;
+  for (auto it = di.begin(); it != di.end(); ++it) {
+    if (it.key() % 2 == 0) {
+      even_keys.push(it.key());
+    }
+  }
+  for (u64 key : even_keys) {
+    di.erase(di.find(key));
+    vdi.erase(vdi.find(key));
+  }
+  mRequire(di.size() == vdi.size());
+  mRequire(sum_values(di) == sum_values(vdi));
+}
+
+namespace {
+  template <typename TDict, typename TKey>
+  void bench_dict_ops(StrView name, ArrView<TKey> keys) {
+    TDict di;
+
+    auto begin = Time::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+      di.insert(TKey(keys[i]), u64(i));
+    }
+    bench_report(fmt(name, " insert"), keys.size(), Time::now() - begin);
+
+    u64 sum = 0;
+    begin   = Time::now();
+    for (int round = 0; round < 4; round++) {
+      for (const TKey& key : keys) {
+        sum += di.find(key).value();
+      }
+    }
+    bench_report(fmt(name, " find"), keys.size() * 4, Time::now() - begin);
+
+    TKey missing = keys[0];
+    begin        = Time::now();
+    for (const TKey& key : keys) {
+      di.erase(key);
+      sum += di.find(missing) ? 1 : 0;
+      missing = key;
+    }
+    bench_report(fmt(name, " erase + find miss"), keys.size(), Time::now() - begin);
+    bench_keep(sum);
+  }
+}  // namespace
+
+mBenchCase(bench_dict_batch) {
+  constexpr size_t count = 2'000'000;
+
+  Arr<Pair<u64, u64>> pairs(count);
+  Arr<u64>            keys(count);
+  u64                 state = 0x9e3779b97f4a7c15ull;
+  for (size_t i = 0; i < count; i++) {
+    keys[i]  = next_random(state);
+    pairs[i] = {keys[i], i};
+  }
+  for (size_t i = 0; i < count; i++) {
+    swap(keys[i], keys[next_random(state) % count]);
+  }
+
+  auto begin = Time::now();
+  {
+    Dict<u64, u64> di;
+    for (auto& pair : pairs) {
+      di.insert(u64(pair.first), u64(pair.second));
+    }
+    bench_report("insert one by one"_sv, count, Time::now() - begin);
+  }
+
+  begin   = Time::now();
+  auto di = Dict<u64, u64>::build_from(pairs);
+  bench_report("build_from"_sv, count, Time::now() - begin);
+
+  u64 sum = 0;
+  begin   = Time::now();
+  for (u64 key : keys) {
+    sum += di.find(key).value();
+  }
+  bench_report("find one by one"_sv, count, Time::now() - begin);
+
+  Arr<u64*> values(count);
+  begin = Time::now();
+  di.find_batch(keys, values);
+  bench_report("find_batch"_sv, count, Time::now() - begin);
+  for (u64* value : values) {
+    sum += *value;
+  }
+  bench_keep(sum);
+}
+
+mBenchCase(bench_dict) {
+  constexpr size_t count = 200'000;
+
+  Arr<u64> ints(count);
+  Arr<Str> strs(count);
+  u64      state = 0x9e3779b97f4a7c15ull;
+  for (size_t i = 0; i < count; i++) {
+    ints[i] = next_random(state);
+    strs[i] = fmt("key-", ints[i]);
+  }
+
+  bench_dict_ops<Dict<u64, u64>>("templated u64"_sv, ArrView<u64>(ints));
+  bench_dict_ops<VDict<u64, u64>>("type-erased u64"_sv, ArrView<u64>(ints));
+  bench_dict_ops<Dict<Str, u64>>("templated str"_sv, ArrView<Str>(strs));
+  bench_dict_ops<VDict<Str, u64>>("type-erased str"_sv, ArrView<Str>(strs));
+}
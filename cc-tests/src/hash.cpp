@@ -0,0 +1,196 @@
+#include "cc/test.hpp"
+#include "cc/hash.hpp"
+#include "cc/str.hpp"
+#include "cc/arr.hpp"
+#include "cc/fmt.hpp"
+#include "cc/time.hpp"
+
+namespace {
+  constexpr char g_text[] =
+      "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor "
+      "jugs! How vexingly quick daft zebras jump; sphinx of black quartz, judge my vow.";
+  constexpr size_t g_text_size = sizeof(g_text) - 1;
+
+  struct PrefixHashes {
+    u64 values[g_text_size + 1];
+  };
+
+  // hashes of every prefix of g_text, computed at compile time
+  constexpr PrefixHashes g_prefix_hashes = [] {
+    PrefixHashes result{};
+    for (size_t i = 0; i <= g_text_size; ++i) {
+      result.values[i] = cc::hash_wy(g_text, i);
+    }
+    return result;
+  }();
+
+  // bit by bit CRC, reflected polynomial
+  u32 crc_bitwise(u32 poly, u32 crc, const void* data, size_t len) {
+    const auto* buf = static_cast<const u8*>(data);
+    crc             = ~crc;
+    for (size_t i = 0; i < len; ++i) {
+      crc ^= buf[i];
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+      }
+    }
+    return ~crc;
+  }
+
+  Arr<u8> crc_test_data(size_t size) {
+    Arr<u8> data(size);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = u8(i * 131 + (i >> 7) * 17);
+    }
+    return data;
+  }
+}  // namespace
+
+mTestCase(hash_wy_reference) {
+  static_assert("abc"_sh.hash() == 0x989b4a209c1011c9ull);
+
+  struct {
+    StrView str;
+    u64     hash;
+  } cases[] = {
+      {""_sv, 0x93228a4de0eec5a2ull},
+      {"a"_sv, 0xaced12527fe5bff8ull},
+      {"abcd"_sv, 0x6d9a9834037410ebull},
+      {"hello world"_sv, 0xe7f8b1dc82171923ull},
+      {"0123456789abcdef"_sv, 0x88de385a856cfb95ull},
+      {"0123456789abcdefg"_sv, 0x14f37288a5f8073aull},
+      {"The quick brown fox jumps over the lazy dog, again and again and again!"_sv,
+       0x09e4cd291701253bull},
+  };
+  for (const auto& [str, hash] : cases) {
+    mRequire(str.hash() == hash);
+    mRequire(cc::hash_wy(str.data(), str.size()) == hash);
+  }
+}
+
+mTestCase(hash_wy_constexpr_matches_runtime) {
+  for (size_t i = 0; i <= g_text_size; ++i) {
+    mRequire(StrView(g_text, i).hash() == g_prefix_hashes.values[i]);
+  }
+  // unaligned reads
+  Str copy(StrView(" ") + StrView(g_text));
+  mRequire(StrView(copy).sub(1).hash() == g_prefix_hashes.values[g_text_size]);
+  mRequire(StrHash(StrView(g_text, 9)) == "The quick"_sh);
+}
+
+mTestCase(hash_crc_reference) {
+  mRequire(cc::crc32_update(0, "123456789", 9) == 0xcbf43926);
+  mRequire(cc::crc32c_update(0, "123456789", 9) == 0xe3069283);
+  mRequire(cc::crc32_update(0, g_text, 43) == 0x414fa339);  // "The quick ... lazy dog"
+  mRequire(cc::crc32_update(0, nullptr, 0) == 0);
+  mRequire(cc::crc32c_update(0, nullptr, 0) == 0);
+
+  u8 bytes[32] = {};  // RFC 3720 CRC-32C examples
+  mRequire(cc::crc32c_update(0, bytes, 32) == 0x8a9136aa);
+  for (u8& byte : bytes) {
+    byte = 0xff;
+  }
+  mRequire(cc::crc32c_update(0, bytes, 32) == 0x62a8ab43);
+
+  // values of former bytewise implementation
+  mRequire(cc::hash_crc32("", 0) == 0xca813bf4);
+  mRequire(cc::hash_crc32("123456789", 9) == 0x465b380f);
+  mRequire(cc::hash_crc32(g_text, 43) == 0x30bf2e89);
+}
+
+mTestCase(hash_crc_matches_bitwise) {
+  constexpr u32 crc32_poly  = 0xedb88320;
+  constexpr u32 crc32c_poly = 0x82f63b78;
+
+  Arr<u8> data  = crc_test_data(8192 + 16);
+  auto    check = [&](size_t offset, size_t len) {
+    const u8* buf = data.data() + offset;
+    mRequire(cc::crc32_update(0, buf, len) == crc_bitwise(crc32_poly, 0, buf, len));
+    mRequire(cc::crc32c_update(0, buf, len) == crc_bitwise(crc32c_poly, 0, buf, len));
+    mRequire(cc::crc32_update(0x12345678, buf, len) ==
+             crc_bitwise(crc32_poly, 0x12345678, buf, len));
+    mRequire(cc::crc32c_update(0x12345678, buf, len) ==
+             crc_bitwise(crc32c_poly, 0x12345678, buf, len));
+  };
+  // table tails, crc32 instruction, folding with every tail size and alignment
+  for (size_t len = 0; len <= 1100; ++len) {
+    check(len % 16, len);
+  }
+  for (size_t len : {1023, 1024, 1025, 4096 + 7, 8192}) {
+    for (size_t offset : {0, 1, 8, 15}) {
+      check(offset, len);
+    }
+  }
+}
+
+mTestCase(hash_crc_streaming) {
+  Arr<u8> data   = crc_test_data(3000);
+  u32     crc32  = cc::crc32_update(0, data.data(), data.size());
+  u32     crc32c = cc::crc32c_update(0, data.data(), data.size());
+
+  for (size_t split : {0, 1, 15, 16, 63, 64, 255, 256, 1000, 2999, 3000}) {
+    u32 part = cc::crc32_update(0, data.data(), split);
+    mRequire(cc::crc32_update(part, data.data() + split, data.size() - split) == crc32);
+    part = cc::crc32c_update(0, data.data(), split);
+    mRequire(cc::crc32c_update(part, data.data() + split, data.size() - split) == crc32c);
+  }
+
+  // many small chunks of varying size
+  u32 part32  = 0;
+  u32 part32c = 0;
+  for (size_t offset = 0, chunk = 1; offset < data.size(); offset += chunk, chunk += 7) {
+    size_t size = mMin(chunk, data.size() - offset);
+    part32      = cc::crc32_update(part32, data.data() + offset, size);
+    part32c     = cc::crc32c_update(part32c, data.data() + offset, size);
+  }
+  mRequire(part32 == crc32);
+  mRequire(part32c == crc32c);
+}
+
+mBenchCase(bench_hash) {
+  constexpr size_t total_bytes = 64 * 1024 * 1024;
+
+  Str data(4096 + 64, 'x');
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = char('a' + i * 7 % 26);
+  }
+
+  for (size_t len : {4, 8, 16, 32, 64, 256, 4096}) {
+    size_t count = total_bytes / len;
+    u64    sum   = 0;
+    auto   begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      sum += cc::hash_fnv64(data.data() + (i & 63), len);
+    }
+    bench_report(fmt("fnv64, ", len, " bytes"), count, Time::now() - begin);
+
+    begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      sum += cc::hash_wy(data.data() + (i & 63), len);
+    }
+    bench_report(fmt("wyhash, ", len, " bytes"), count, Time::now() - begin);
+    bench_keep(sum);
+  }
+}
+
+mBenchCase(bench_crc) {
+  constexpr size_t total_bytes = 256 * 1024 * 1024;
+
+  Arr<u8> data = crc_test_data(64 * 1024 + 64);
+  for (size_t len : {16, 64, 256, 4096, 64 * 1024}) {
+    size_t count = total_bytes / len;
+    u32    sum   = 0;
+    auto   begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      sum += cc::crc32_update(0, data.data() + (i & 63), len);
+    }
+    bench_report(fmt("crc32, ", len, " bytes"), count, Time::now() - begin);
+
+    begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      sum += cc::crc32c_update(0, data.data() + (i & 63), len);
+    }
+    bench_report(fmt("crc32c, ", len, " bytes"), count, Time::now() - begin);
+    bench_keep(sum);
+  }
+}
@@ -0,0 +1,137 @@
+#include "cc/test.hpp"
+#include "cc/intrusive.hpp"
+#include "cc/str.hpp"
+#include "cc/fmt.hpp"
+
+namespace {
+  struct Entry {
+    u64      id = 0;
+    Str      name;
+    ListLink lru_link;
+    ListLink all_link;
+    HashLink id_link;
+    HashLink name_link;
+  };
+
+  using Lru    = IntrusiveList<Entry, &Entry::lru_link>;
+  using All    = IntrusiveList<Entry, &Entry::all_link>;
+  using ById   = IntrusiveHashMap<u64, Entry, &Entry::id, &Entry::id_link>;
+  using ByName = IntrusiveHashMap<Str, Entry, &Entry::name, &Entry::name_link>;
+}  // namespace
+
+mTestCase(intrusive_list) {
+  Entry entries[4];
+  for (u64 i = 0; i < 4; ++i) {
+    entries[i].id = i;
+  }
+  {
+    Lru lru;
+    All all;
+    for (auto& entry : entries) {
+      lru.push_back(entry);
+      all.push_front(entry);
+    }
+    mRequire(lru.size() == 4 && all.size() == 4);
+    mRequire(lru.front().id == 0 && all.front().id == 3);
+
+    lru.move_to_front(entries[2]);
+    u64    expected_lru[] = {2, 0, 1, 3};
+    size_t i              = 0;
+    for (Entry& entry : lru) {
+      mRequire(entry.id == expected_lru[i++]);
+    }
+
+    mRequire(lru.pop_back().id == 3);
+    mRequire(!entries[3].lru_link.is_linked());
+    mRequire(entries[3].all_link.is_linked());
+    lru.remove(entries[0]);
+    mRequire(lru.size() == 2);
+    mRequire(lru.front().id == 2 && lru.back().id == 1);
+
+    Lru moved(move(lru));
+    mRequire(lru.empty() && moved.size() == 2);
+    mRequire(moved.pop_front().id == 2);
+    moved.push_front(entries[3]);
+    mRequire(moved.front().id == 3);
+  }
+  for (auto& entry : entries) {
+    mRequire(!entry.lru_link.is_linked() && !entry.all_link.is_linked());
+  }
+}
+
+mTestCase(intrusive_hash_map) {
+  constexpr size_t count = 200;
+  Entry            entries[count];
+  ById             by_id;
+  ByName           by_name;
+  for (u64 i = 0; i < count; ++i) {
+    entries[i].id   = i * 7;
+    entries[i].name = fmt("e", i);
+    mRequire(by_id.insert(entries[i]));
+    mRequire(by_name.insert(entries[i]));
+  }
+  mRequire(by_id.size() == count);
+
+  Entry duplicate;
+  duplicate.id = 7;
+  mRequire(!by_id.insert(duplicate));
+
+  mRequire(by_id.find(14) == &entries[2]);
+  mRequire(by_id.find(15) == nullptr);
+  mRequire(by_name.find("e42"_sv) == &entries[42]);
+  mRequire(by_name.contains("e199"_s));
+
+  mRequire(by_id.erase(14) == &entries[2]);
+  mRequire(by_id.erase(14) == nullptr);
+  by_name.remove(entries[3]);
+  mRequire(!by_name.contains("e3"_sv));
+
+  size_t visited = 0;
+  u64    sum     = 0;
+  for (Entry& entry : by_id) {
+    sum += entry.id;
+    ++visited;
+  }
+  mRequire(visited == count - 1);
+  mRequire(sum == 7 * (count * (count - 1) / 2) - 14);
+
+  ById moved(move(by_id));
+  mRequire(by_id.empty() && by_id.begin() == by_id.end());
+  mRequire(moved.find(7) == &entries[1]);
+}
+
+mTestCase(intrusive_lru) {
+  constexpr size_t capacity = 3;
+  Entry            entries[8];
+  Lru              lru;
+  ById             by_id;
+
+  size_t next  = 0;
+  auto   touch = [&](u64 id) -> bool {
+    if (Entry* hit = by_id.find(id)) {
+      lru.move_to_front(*hit);
+      return true;
+    }
+    Entry* entry;
+    if (lru.size() == capacity) {
+      entry = &lru.pop_back();
+      by_id.remove(*entry);
+    } else {
+      entry = &entries[next++];
+    }
+    entry->id = id;
+    by_id.insert(*entry);
+    lru.push_front(*entry);
+    return false;
+  };
+
+  mRequire(!touch(1));
+  mRequire(!touch(2));
+  mRequire(!touch(3));
+  mRequire(touch(1));
+  mRequire(!touch(4));  // evicts 2
+  mRequire(!by_id.contains(2));
+  mRequire(touch(3) && touch(1) && touch(4));
+  mRequire(by_id.size() == capacity && next == capacity);
+  lru.clear();
+}
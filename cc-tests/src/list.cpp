@@ -2,6 +2,7 @@
 #include "cc/test.hpp"
 #include "cc/list.hpp"
 #include "cc/fmt.hpp"
+#include "cc/time.hpp"
 
 
 mTestCase(list_default_ctor) {
@@ -261,3 +262,84 @@ mTestCase(list_remove_prev) {
   --it;
   mRequire(*it == 1);
 }
+
+
+mTestCase(list_pool_reuse) {
+  PoolAllocator<u64, 4, 8> pool;
+  u64*                     a = pool.allocate();
+  u64*                     b = pool.allocate();
+  mRequire(b == a + 1);
+  pool.deallocate(a);
+  mRequire(pool.allocate() == a);
+  for (size_t i = 0; i < 10; ++i) {
+    pool.allocate();
+  }
+  mRequire(pool.capacity() == 4 + 8);
+
+  List<Str> queue;
+  for (size_t round = 0; round < 100; ++round) {
+    for (size_t i = 0; i < 10; ++i) {
+      queue.push_back(fmt(i));
+    }
+    for (size_t i = 0; i < 10; ++i) {
+      mRequire(queue.pop_front() == fmt(i));
+    }
+  }
+  mRequire(queue.empty());
+}
+
+
+mTestCase(list_append_pools) {
+  List<Str> a;
+  List<Str> b;
+  for (size_t i = 0; i < 40; ++i) {
+    a.push_back(fmt(i));
+    b.push_back(fmt(i + 40));
+  }
+  b.pop_front();
+  b.push_front("40"_s);
+
+  a.append(move(b));
+  mRequire(b.empty());
+  mRequire(a.size() == 80);
+  size_t i = 0;
+  for (const Str& value : a) {
+    mRequire(value == fmt(i++));
+  }
+  while (!a.empty()) {
+    a.pop_back();
+  }
+  a.push_back("x"_s);
+  mRequire(a.size() == 1);
+
+  List<Str, HeapAllocator<List<Str>::Node>> heap;
+  heap.push_back("y"_s);
+  heap.push_front("x"_s);
+  mRequireEqStr(fmt(heap), "[x, y]");
+}
+
+
+mBenchCase(bench_list_queue) {
+  constexpr size_t count = 2'000'000;
+  constexpr size_t depth = 256;
+
+  auto run = [&]<typename TList>(StrView name) {
+    TList list;
+    u64   sum   = 0;
+    auto  begin = Time::now();
+    for (size_t i = 0; i < count; ++i) {
+      list.push_back(i);
+      if (list.size() > depth) {
+        sum += list.pop_front();
+      }
+    }
+    for (u64 value : list) {
+      sum += value;
+    }
+    bench_report(name, count, Time::now() - begin);
+    bench_keep(sum);
+  };
+
+  run.template operator()<List<u64, HeapAllocator<List<u64>::Node>>>("heap nodes"_sv);
+  run.template operator()<List<u64>>("pool nodes"_sv);
+}
@@ -0,0 +1,252 @@
+#include "cc/test.hpp"
+#include "cc/parallel.hpp"
+#include "cc/fmt.hpp"
+
+namespace {
+  Arr<u64> make_random(size_t count) {
+    Arr<u64> arr(count);
+    u64      state = 0x9e3779b97f4a7c15ull;
+    for (auto& v : arr) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      v = state % 1'000'000;
+    }
+    return arr;
+  }
+
+  void square(u64& value) {
+    value *= value;
+  }
+
+  void fail_on_odd(u64& value) {
+    if (value % 2 != 0) {
+      throw Err("odd value"_s);
+    }
+  }
+}  // namespace
+
+mTestCase(parallel_for_values) {
+  Arr<u64> values(1000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  mRequire(parallel_for<u64>(values, square) == 0);
+  for (size_t i = 0; i < values.size(); ++i) {
+    mRequire(values[i] == i * i);
+  }
+  mRequire(parallel_for<u64>(values, fail_on_odd) == 500);
+
+  u64 offset = 3;
+  mRequire(parallel_for(ArrView<u64>(values), [&](u64& v) { v += offset; }, nullptr, 7) ==
+           0);
+  for (size_t i = 0; i < values.size(); ++i) {
+    mRequire(values[i] == i * i + offset);
+  }
+}
+
+mTestCase(parallel_for_range) {
+  for (size_t count : {size_t(0), size_t(1), size_t(5), size_t(100'000)}) {
+    for (size_t grain : {size_t(0), size_t(1), size_t(3), size_t(1000)}) {
+      Arr<u8> visits(count + 10);
+      memset(visits.data(), 0, visits.size());
+      int failed = parallel_for(
+          10, count + 10,
+          [&](size_t i) {
+            ++visits[i];
+            if (i % 1000 == 0) {
+              throw Err("every 1000"_s);
+            }
+          },
+          grain);
+
+      mRequire(failed == int((count + 999 + 10) / 1000 - (10 + 999) / 1000));
+      for (size_t i = 0; i < visits.size(); ++i) {
+        mRequire(visits[i] == (i < 10 ? 0 : 1));
+      }
+    }
+  }
+}
+
+mTestCase(parallel_for_foreign_exception) {
+  for (size_t grain : {size_t(0), size_t(1), size_t(64)}) {
+    AtomicInt visited = 0;
+    int       failed  = parallel_for(
+        0, 10'000,
+        [&](size_t i) {
+          ++visited;
+          if (i % 100 == 0) {
+            throw 42;
+          }
+        },
+        grain);
+    mRequire(failed == 100);
+    mRequire(visited.load() == 10'000);
+  }
+}
+
+mTestCase(parallel_for_guided_chunks) {
+  size_t remaining = 100'000;
+  size_t chunk     = details::parallel_for_guided_chunk(remaining, 4, 100);
+  mRequire(chunk == 12'500);
+  size_t chunks = 0;
+  while (remaining > 0) {
+    size_t next = details::parallel_for_guided_chunk(remaining, 4, 100);
+    mRequire(next <= chunk && next >= 100);
+    chunk = next;
+    remaining -= mMin(chunk, remaining);
+    ++chunks;
+  }
+  mRequire(chunk == 100);
+  mRequire(chunks < 100'000 / 100);
+}
+
+mTestCase(parallel_split_into_groups) {
+  Arr<int> values{1, 2, 3, 4, 5, 6, 7};
+  auto     groups = split_into_groups(ArrView<int>(values), 3);
+  mRequire(groups.size() == 3);
+  mRequire(groups[0].size() == 3);
+  mRequire(groups[1].size() == 2);
+  mRequire(groups[2].size() == 2);
+  mRequire(groups[0].data() == values.data());
+  mRequire(groups[2][1] == 7);
+
+  auto copies = values.split_into_groups(3);
+  mRequire(copies.size() == 3);
+  mRequire(copies[1] == groups[1]);
+  mRequire(copies[1].data() != groups[1].data());
+}
+
+mTestCase(parallel_sort_values) {
+  for (size_t count : {size_t(0), size_t(1), size_t(1000), size_t(100'000)}) {
+    auto values   = make_random(count);
+    auto expected = values;
+    sort(ArrView<u64>(expected));
+
+    parallel_sort(ArrView<u64>(values));
+    mRequire(values == expected);
+
+    parallel_sort(ArrView<u64>(values), [](const u64& a, const u64& b) { return a > b; });
+    for (size_t i = 0; i < count; ++i) {
+      mRequire(values[i] == expected[count - i - 1]);
+    }
+  }
+
+  Arr<Str> strs;
+  for (auto v : make_random(50'000)) {
+    strs.push(fmt(v));
+  }
+  parallel_sort(ArrView<Str>(strs));
+  for (size_t i = 1; i < strs.size(); ++i) {
+    mRequire(strs[i - 1].compare(strs[i]) != ComparePos::Greater);
+  }
+}
+
+mTestCase(parallel_reduce_values) {
+  for (size_t count : {size_t(0), size_t(10), size_t(100'000)}) {
+    auto values   = make_random(count);
+    u64  expected = 0;
+    for (auto v : values) {
+      expected += v;
+    }
+
+    u64 sum = parallel_reduce(
+        ArrView<u64>(values), u64(0), [](u64 acc, const u64& v) { return acc + v; },
+        [](u64 a, u64 b) { return a + b; });
+    mRequire(sum == expected);
+  }
+
+  // combine keeps order of chunks
+  Arr<u64> digits(20'000);
+  for (size_t i = 0; i < digits.size(); ++i) {
+    digits[i] = i;
+  }
+  auto concat = [](Arr<u64> a, Arr<u64> b) {
+    a.append(b);
+    return a;
+  };
+  auto collected = parallel_reduce(
+      ArrView<u64>(digits), Arr<u64>(),
+      [](Arr<u64> acc, const u64& v) {
+        acc.push(v);
+        return acc;
+      },
+      concat);
+  mRequire(collected == digits);
+}
+
+mTestCase(parallel_transform_values) {
+  auto     values = make_random(100'000);
+  Arr<Str> out(values.size());
+  u64      offset = 7;
+  parallel_transform(ArrView<u64>(values), ArrView<Str>(out),
+                     [&](const u64& v) { return fmt(v + offset); });
+  for (size_t i = 0; i < values.size(); ++i) {
+    mRequire(out[i] == fmt(values[i] + offset));
+  }
+}
+
+mBenchCase(bench_parallel_sort) {
+  constexpr size_t count  = 4'000'000;
+  auto             values = make_random(count);
+
+  auto arr   = values;
+  auto begin = Time::now();
+  sort(ArrView<u64>(arr), [](const u64& a, const u64& b) { return a < b; });
+  bench_report("sort"_sv, count, Time::now() - begin);
+
+  arr   = values;
+  begin = Time::now();
+  parallel_sort(ArrView<u64>(arr), [](const u64& a, const u64& b) { return a < b; });
+  bench_report(fmt("parallel sort, threads: ", Thread::hardware_thread_count()), count,
+               Time::now() - begin);
+
+  begin   = Time::now();
+  u64 sum = 0;
+  for (auto v : values) {
+    sum += v;
+  }
+  bench_keep(sum);
+  bench_report("sum"_sv, count, Time::now() - begin);
+
+  begin = Time::now();
+  sum   = parallel_reduce(
+      ArrView<u64>(values), u64(0), [](u64 acc, const u64& v) { return acc + v; },
+      [](u64 a, u64 b) { return a + b; });
+  bench_keep(sum);
+  bench_report("parallel reduce sum"_sv, count, Time::now() - begin);
+}
+
+mBenchCase(bench_parallel_for_tiny) {
+  constexpr size_t count = 4'000'000;
+  Arr<u64>         values(count);
+
+  auto begin = Time::now();
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = i * i;
+  }
+  bench_keep(values[count / 2]);
+  bench_report("serial loop"_sv, count, Time::now() - begin);
+
+  begin = Time::now();
+  parallel_for(0, count, [&](size_t i) { values[i] = i * i; });
+  bench_keep(values[count / 2]);
+  bench_report("parallel_for range"_sv, count, Time::now() - begin);
+
+  begin = Time::now();
+  parallel_for<u64>(values, square);
+  bench_keep(values[count / 2]);
+  bench_report("parallel_for values"_sv, count, Time::now() - begin);
+}
+
+mBenchCase(bench_parallel_for_calls) {
+  constexpr size_t calls  = 10'000;
+  Arr<u64>         values = make_random(64);
+
+  auto begin = Time::now();
+  for (size_t i = 0; i < calls; ++i) {
+    parallel_for<u64>(values, square);
+  }
+  bench_report(fmt("parallel_for of ", values.size(), " values"), calls,
+               Time::now() - begin);
+}
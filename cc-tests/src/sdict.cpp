@@ -1,5 +1,17 @@
 #include "cc/test.hpp"
 #include "cc/sdict.hpp"
+#include "cc/str.hpp"
+#include "cc/fmt.hpp"
+#include "cc/time.hpp"
+
+namespace {
+  u64 next_random(u64& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+}  // namespace
 
 mTestCase(sdict) {
   SDict<u64, StrView> dict;
@@ -55,3 +67,155 @@ mTestCase(sdict) {
   }
   mRequire(iter == 3);
 }
+
+mTestCase(sdict_sort_large) {
+  constexpr size_t count = 5000;
+  SDict<u64, u64>  dict;
+  dict.reserve(count);
+  u64 state = 0x9e3779b97f4a7c15ull;
+  for (size_t i = 0; i < count; ++i) {
+    u64 key = next_random(state);
+    dict.insert(key, ~key);
+  }
+  mRequire(!dict.is_sorted());
+  dict.sort();
+  mRequire(dict.is_sorted());
+  auto keys   = dict.keys();
+  auto values = dict.values();
+  for (size_t i = 0; i < count; ++i) {
+    mRequire(values[i] == ~keys[i]);
+    mRequire(dict.lower_bound(keys[i]) == i);
+    mRequire(*dict.find(keys[i]) == ~keys[i]);
+  }
+}
+
+mTestCase(sdict_bounds) {
+  SDict<u64, u64> dict;
+  mRequire(dict.lower_bound(1) == 0);
+  mRequire(dict.upper_bound(1) == 0);
+  mRequire(dict.range(0, 10).size() == 0);
+
+  dict.reserve(5);
+  for (u64 key : {50, 10, 40, 20, 30}) {
+    dict.insert(key, key * 2);
+  }
+  dict.sort();
+
+  mRequire(dict.lower_bound(5) == 0);
+  mRequire(dict.lower_bound(10) == 0);
+  mRequire(dict.upper_bound(10) == 1);
+  mRequire(dict.lower_bound(25) == 2);
+  mRequire(dict.upper_bound(25) == 2);
+  mRequire(dict.lower_bound(50) == 4);
+  mRequire(dict.upper_bound(50) == 5);
+  mRequire(dict.lower_bound(60) == 5);
+
+  auto range = dict.range(15, 40);
+  mRequire(range.size() == 2);
+  mRequire(range.keys[0] == 20 && range.values[0] == 40);
+  mRequire(range.keys[1] == 30 && range.values[1] == 60);
+  mRequire(dict.range(40, 15).size() == 0);
+  mRequire(dict.range(0, 100).size() == 5);
+}
+
+mTestCase(sdict_insert_sorted) {
+  SDict<u64, Str> dict;
+  dict.reserve(3);
+  dict.insert(20, "20"_s);
+  dict.insert(40, "40"_s);
+  dict.insert(60, "60"_s);
+
+  u64 keys[]   = {10, 30, 50, 70, 80};
+  Str values[] = {"10"_s, "30"_s, "50"_s, "70"_s, "80"_s};
+  dict.insert_sorted(ArrView(keys), ArrView(values));
+  mRequire(dict.size() == 8);
+  mRequire(dict.is_sorted());
+  for (u64 key = 10; key <= 80; key += 10) {
+    mRequire(dict.find(key) != nullptr);
+    mRequireEqStr(*dict.find(key), fmt(key));
+  }
+  mRequire(dict.find(15) == nullptr);
+
+  u64 more_keys[]   = {0};
+  Str more_values[] = {"0"_s};
+  dict.insert_sorted(ArrView(more_keys), ArrView(more_values));
+  mRequire(dict.keys()[0] == 0);
+  mRequireEqStr(dict.values()[0], "0");
+  mRequire(dict.is_sorted());
+}
+
+namespace {
+  // no default constructor: insert_sorted must only move into slots
+  struct SDictValue {
+    u64 key;
+
+    explicit SDictValue(u64 a_key) : key(a_key) {}
+  };
+}  // namespace
+
+mTestCase(sdict_insert_sorted_random) {
+  u64 state = 0x2545f4914f6cdd1dull;
+  for (size_t round = 0; round < 200; ++round) {
+    size_t old_count = next_random(state) % 40;
+    size_t new_count = next_random(state) % 40;
+
+    // even keys are in dict, odd keys are inserted, so both sets are disjoint
+    Arr<u64> old_keys;
+    for (size_t i = 0; i < old_count; ++i) {
+      old_keys.push(next_random(state) % 200 * 2);
+    }
+    sort(ArrView<u64>(old_keys));
+    Arr<u64> new_keys;
+    for (size_t i = 0; i < new_count; ++i) {
+      new_keys.push(next_random(state) % 200 * 2 + 1);
+    }
+    sort(ArrView<u64>(new_keys));
+
+    SDict<u64, SDictValue> dict;
+    for (size_t i = 0; i < old_keys.size(); ++i) {
+      if (i == 0 || old_keys[i] != old_keys[i - 1]) {
+        dict.insert(old_keys[i], SDictValue(old_keys[i]));
+      }
+    }
+    Arr<u64>        keys;
+    Arr<SDictValue> values;
+    for (size_t i = 0; i < new_keys.size(); ++i) {
+      if (i == 0 || new_keys[i] != new_keys[i - 1]) {
+        keys.push(new_keys[i]);
+        values.push(SDictValue(new_keys[i]));
+      }
+    }
+
+    size_t expected_size = dict.size() + keys.size();
+    dict.insert_sorted(keys, values);
+    mRequire(dict.size() == expected_size);
+    for (size_t i = 0; i < dict.size(); ++i) {
+      mRequire(i == 0 || dict.keys()[i - 1] < dict.keys()[i]);
+      mRequire(dict.values()[i].key == dict.keys()[i]);
+    }
+  }
+}
+
+mBenchCase(bench_sdict) {
+  constexpr size_t count   = 1'000'000;
+  constexpr size_t lookups = 4'000'000;
+
+  SDict<u64, u64> dict;
+  dict.reserve(count);
+  u64 state = 0x9e3779b97f4a7c15ull;
+  for (size_t i = 0; i < count; ++i) {
+    dict.insert(next_random(state), i);
+  }
+
+  auto begin = Time::now();
+  dict.sort();
+  bench_report("sdict sort"_sv, count, Time::now() - begin);
+
+  u64 sum = 0;
+  begin   = Time::now();
+  for (size_t i = 0; i < lookups; ++i) {
+    sum += dict.lower_bound(next_random(state));
+  }
+  bench_report("sdict lower_bound"_sv, lookups, Time::now() - begin);
+  bench_keep(sum);
+}
@@ -1,5 +1,7 @@
 #include "cc/test.hpp"
 #include "cc/set.hpp"
+#include "cc/str.hpp"
+#include "cc/fmt.hpp"
 
 struct CustomKey {
   int key;
@@ -51,3 +53,102 @@ mTestCase(set_basic) {
     mRequire(set.find(2) == set.end());
   }
 }
+
+mTestCase(set_large_iterate_copy) {
+  Set<u64> set;
+  u64      sum = 0;
+  for (u64 i = 0; i < 10'000; i++) {
+    set.insert(i * 7919);
+    sum += i * 7919;
+  }
+  for (u64 i = 0; i < 10'000; i += 3) {
+    mRequire(set.erase(i * 7919));
+    sum -= i * 7919;
+  }
+
+  Set<u64> copy(set);
+  for (const Set<u64>* s : {&set, &copy}) {
+    size_t count      = 0;
+    u64    copied_sum = 0;
+    for (u64 key : *s) {
+      copied_sum += key;
+      count++;
+    }
+    mRequire(count == s->size());
+    mRequire(copied_sum == sum);
+  }
+  mRequire(copy.find(7919) != copy.end());
+  mRequire(copy.find(0) == copy.end());
+}
+
+mTestCase(set_lookup_key) {
+  Set<Str> set;
+  set.insert(Str("a"));
+  set.insert(Str("b"));
+
+  mRequire(set.contains("a"_sv));
+  mRequire(set.contains(Str("b")));
+  mRequire(!set.contains("c"_sv));
+  mRequire(set.find("b"_sv) != set.end());
+  mRequire(*set.find("b"_sv) == "b"_sv);
+
+  mRequire(set.erase("a"_sv));
+  mRequire(!set.erase("a"_sv));
+  mRequire(set.size() == 1);
+}
+
+mTestCase(set_algebra) {
+  Set<u64> small;
+  Set<u64> large;
+  for (u64 i = 0; i < 10; ++i) {
+    small.insert(i * 3);
+  }
+  for (u64 i = 0; i < 100; ++i) {
+    large.insert(i * 2);
+  }
+
+  for (auto [a, b] : {Pair{&small, &large}, Pair{&large, &small}}) {
+    auto united = set_union(*a, *b);
+    mRequire(united.size() == 100 + 5);
+    mRequire(united.contains(27) && united.contains(198));
+
+    auto common = set_intersect(*a, *b);
+    mRequire(common.size() == 5);
+    for (u64 key : common) {
+      mRequire(key % 6 == 0);
+    }
+  }
+
+  auto small_only = set_difference(small, large);
+  mRequire(small_only.size() == 5);
+  mRequire(small_only.contains(3) && !small_only.contains(6));
+  auto large_only = set_difference(large, small);
+  mRequire(large_only.size() == 95);
+  mRequire(large_only.contains(2) && !large_only.contains(0));
+
+  mRequire(!is_subset(small, large));
+  mRequire(!is_subset(large, small));
+  mRequire(is_subset(set_intersect(small, large), small));
+  mRequire(is_subset(Set<u64>(), small));
+}
+
+mTestCase(set_merge) {
+  Set<Str> a;
+  Set<Str> b;
+  a.insert("x"_s);
+  for (u64 i = 0; i < 50; ++i) {
+    b.insert(fmt(i));
+  }
+
+  Set<Str> copy;
+  copy.merge(a);
+  copy.merge(b);
+  mRequire(copy.size() == 51);
+  mRequire(b.size() == 50);
+
+  a.merge(move(b));
+  mRequire(a.size() == 51);
+  mRequire(b.size() == 0);
+  mRequire(a.contains("x"_sv) && a.contains("49"_sv));
+  mRequire(is_subset(a, copy) && is_subset(copy, a));
+}
@@ -0,0 +1,96 @@
+#include "cc/test.hpp"
+#include "cc/small-set.hpp"
+#include "cc/str.hpp"
+#include "cc/fmt.hpp"
+#include "cc/time.hpp"
+
+mTestCase(small_set_inline) {
+  SmallSet<u64, 4> set;
+  mRequire(set.empty());
+  mRequire(set.insert(1));
+  mRequire(set.insert(2));
+  mRequire(!set.insert(2));
+  mRequire(set.insert(3));
+  mRequire(set.size() == 3);
+  mRequire(set.is_inline());
+  mRequire(set.contains(2));
+  mRequire(*set.find(3) == 3);
+  mRequire(set.find(4) == set.end());
+
+  mRequire(set.erase(1));
+  mRequire(!set.erase(1));
+  mRequire(set.size() == 2);
+  u64 sum = 0;
+  for (u64 key : set) {
+    sum += key;
+  }
+  mRequire(sum == 5);
+}
+
+mTestCase(small_set_promote) {
+  SmallSet<Str, 4> set;
+  for (u64 i = 0; i < 4; ++i) {
+    set.insert(fmt(i));
+  }
+  mRequire(set.is_inline());
+  mRequire(set.insert("4"_s));
+  mRequire(!set.is_inline());
+  mRequire(!set.insert("4"_s));
+  for (u64 i = 5; i < 100; ++i) {
+    set.insert(fmt(i));
+  }
+  mRequire(set.size() == 100);
+  mRequire(set.contains("0"_s));
+  mRequire(set.contains("99"_sv));
+  mRequire(set.find("42"_sv) != set.end());
+  mRequire(set.erase("42"_sv));
+  mRequire(!set.contains("42"_s));
+
+  size_t count = 0;
+  for (const Str& key : set) {
+    mRequire(key != "42"_s);
+    ++count;
+  }
+  mRequire(count == 99);
+
+  SmallSet<Str, 4> copy(set);
+  mRequire(copy.size() == 99 && copy.contains("7"_sv));
+  SmallSet<Str, 4> moved(move(copy));
+  mRequire(moved.size() == 99 && moved.contains("7"_sv));
+  mRequire(copy.empty() && copy.is_inline());
+
+  set.clear();
+  mRequire(set.empty() && set.is_inline());
+  set.insert("a"_s);
+  SmallSet<Str, 4> inline_copy;
+  inline_copy = set;
+  mRequire(inline_copy.size() == 1 && inline_copy.contains("a"_sv));
+  inline_copy = move(set);
+  mRequire(inline_copy.size() == 1 && set.empty());
+}
+
+mBenchCase(bench_small_set) {
+  constexpr size_t count = 1'000'000;
+
+  u64  sum   = 0;
+  auto begin = Time::now();
+  for (size_t i = 0; i < count; ++i) {
+    Set<u64> set;
+    for (u64 key = 0; key < 8; ++key) {
+      set.insert(i + key);
+    }
+    sum += set.contains(i + 3);
+  }
+  bench_report("set, 8 keys"_sv, count, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t i = 0; i < count; ++i) {
+    SmallSet<u64> set;
+    for (u64 key = 0; key < 8; ++key) {
+      set.insert(i + key);
+    }
+    sum += set.contains(i + 3);
+  }
+  bench_report("small set, 8 keys"_sv, count, Time::now() - begin);
+  bench_keep(sum);
+}
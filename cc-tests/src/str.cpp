@@ -2,6 +2,8 @@
 #include "cc/str.hpp"
 
 #include "cc/fmt.hpp"
+#include "cc/arr.hpp"
+#include "cc/time.hpp"
 
 auto g_static_string_test = "StaticString";
 
@@ -67,16 +69,23 @@ mTestCase(str_copy_assignment) {
 }
 
 mTestCase(str_move_ctor) {
-  Str  s("hello");
+  Str  s("string which does not fit inline");
   auto old_data = s.data();
   auto old_size = s.size();
   Str  s2(move(s));
   mRequire(s2.size() == old_size);
   mRequire(s2.data() == old_data);
+  mRequire(s.empty());
+
+  Str inline_str("hello");
+  Str inline_moved(move(inline_str));
+  mRequire(inline_moved.is_inline());
+  mRequireEqBytes(inline_moved.data(), "hello", 5);
+  mRequire(inline_str.empty());
 }
 
 mTestCase(str_move_assignment) {
-  Str  s("hello");
+  Str  s("string which does not fit inline");
   auto old_data = s.data();
   auto old_size = s.size();
   Str  s2;
@@ -112,6 +121,61 @@ mTestCase(str_resize_zero) {
   mRequire(s.data() != nullptr);
 }
 
+mTestCase(str_inline) {
+  Str s(Str::inline_capacity, 'a');
+  mRequire(s.is_inline());
+  mRequire(s.capacity() == Str::inline_capacity);
+
+  Str copy = s;
+  mRequire(copy.is_inline() && copy.data() != s.data());
+  mRequire(copy == s);
+
+  s += "b"_sv;
+  mRequire(!s.is_inline());
+  mRequire(s.size() == Str::inline_capacity + 1);
+  mRequire(s.starts_with(copy) && s.ends_with('b'));
+
+  s.resize(3);
+  mRequire(s.size() == 3);
+  mRequire(s == "aaa"_sv);
+  s = "short"_sv;
+  mRequire(s == "short"_sv);
+
+  Arr<Str> strs;
+  for (int i = 0; i < 100; ++i) {
+    strs.push(fmt(i));
+    strs.push(Str(40, char('a' + i % 26)));
+  }
+  for (int i = 0; i < 100; ++i) {
+    mRequire(strs[size_t(i) * 2] == fmt(i));
+    mRequire(strs[size_t(i) * 2 + 1] == Str(40, char('a' + i % 26)));
+  }
+}
+
+mTestCase(str_append_growth) {
+  Str    s;
+  size_t capacity_changes = 0;
+  size_t last_capacity    = 0;
+  for (int i = 0; i < 10'000; ++i) {
+    s += "abc"_sv;
+    if (s.capacity() != last_capacity) {
+      last_capacity = s.capacity();
+      ++capacity_changes;
+    }
+  }
+  mRequire(s.size() == 30'000);
+  mRequire(capacity_changes < 20);
+  for (size_t i = 0; i < s.size(); i += 3) {
+    mRequire(s.sub(i, 3) == "abc"_sv);
+  }
+
+  Str reserved;
+  reserved.reserve(100);
+  mRequire(reserved.capacity() == 100 && reserved.empty());
+  reserved += "x"_sv;
+  mRequire(reserved.capacity() == 100);
+}
+
 mTestCase(str_for_loop) {
   Str s(10, 'x');
   for (auto& c : s) {
@@ -134,6 +198,7 @@ mTestCase(str_eq_op) {
   mRequire(s == Str("hello"));
   mRequire(s != Str("hell"));
   mRequire(s != Str("helloo"));
+  mRequire(Str("a\0b", 3) != StrView("a\0c", 3));
 
   Str empty;
   mRequire(empty == "");
@@ -209,6 +274,92 @@ mTestCase(strview_find_str) {
   mRequire(StrView("121200").find_last("12") == 2);
 }
 
+namespace {
+  u64 next_random(u64& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  // Random text over small alphabet, so terms match often and partially.
+  Str random_text(size_t size, u64& state, StrView alphabet = "abcd"_sv) {
+    Str text(size);
+    for (char& c : text) {
+      c = alphabet[next_random(state) % alphabet.size()];
+    }
+    return text;
+  }
+
+  size_t naive_find(StrView text, StrView term) {
+    if (term.size() > text.size()) {
+      return StrView::npos;
+    }
+    for (size_t i = 0; i + term.size() <= text.size(); ++i) {
+      if (memcmp(text.data() + i, term.data(), term.size()) == 0) {
+        return i;
+      }
+    }
+    return StrView::npos;
+  }
+
+  size_t naive_find_any_of(StrView text, StrView chars) {
+    for (size_t i = 0; i < text.size(); ++i) {
+      for (char c : chars) {
+        if (text[i] == c) {
+          return i;
+        }
+      }
+    }
+    return StrView::npos;
+  }
+}  // namespace
+
+mTestCase(strview_find_simd) {
+  u64 state = 0x9e3779b97f4a7c15ull;
+  for (size_t size : {1, 15, 16, 17, 31, 33, 63, 64, 65, 100, 300, 1000}) {
+    Str text = random_text(size, state);
+    for (size_t offset = 0; offset < 3 && offset < size; ++offset) {
+      StrView view = text.sub(offset);
+      mRequire(view.find('e') == StrView::npos);
+      for (char c : "abcd"_sv) {
+        mRequire(view.find(c) == naive_find(view, StrView(&c, 1)));
+      }
+      for (size_t term_size = 1; term_size <= 12; ++term_size) {
+        Str term = random_text(term_size, state);
+        mRequire(view.find(term) == naive_find(view, term));
+        if (term_size <= view.size()) {
+          StrView tail = view.sub(view.size() - term_size);
+          mRequire(view.find(tail) == naive_find(view, tail));
+        }
+      }
+    }
+  }
+
+  Str text(1000, 'a');
+  text[999] = 'b';
+  mRequire(StrView(text).find('b') == 999);
+  mRequire(StrView(text).find("ab"_sv) == 998);
+  mRequire(StrView(text).find("aab"_sv) == 997);
+  mRequire(StrView(text).find("ba"_sv) == StrView::npos);
+}
+
+mTestCase(strview_find_any_of) {
+  mRequire(StrView("key = value;").find_any_of("=;"_sv) == 4);
+  mRequire(StrView("key = value;").find_any_of(";"_sv) == 11);
+  mRequire(StrView("key").find_any_of(";="_sv) == StrView::npos);
+  mRequire(StrView("key").find_any_of(""_sv) == StrView::npos);
+  mRequire(StrView().find_any_of(";"_sv) == StrView::npos);
+
+  u64 state = 0x9e3779b97f4a7c15ull;
+  for (size_t size : {5, 16, 40, 100, 1000}) {
+    Str text = random_text(size, state, "abcdefghijklmnopqrstuvwxyz"_sv);
+    for (StrView chars : {"xy"_sv, "qwe"_sv, "zxcvbnm"_sv, "abcdefghi"_sv, "0z"_sv}) {
+      mRequire(StrView(text).find_any_of(chars) == naive_find_any_of(text, chars));
+    }
+  }
+}
+
 mTestCase(strview_split) {
   StrView s_cont[8];
 
@@ -443,3 +594,130 @@ mTestCase(str_to_lower_to_upper) {
   mRequireEqStr(Str("aBcDe").to_lower(), "abcde");
   mRequireEqStr(Str("aBcDe").to_upper(), "ABCDE");
 }
+
+mTestCase(str_builder_move) {
+  StrBuilder small;
+  small.append("abc"_sv);
+  StrBuilder moved(move(small));
+  mRequire(moved.view() == "abc"_sv);
+  mRequire(small.view().empty());
+
+  StrBuilder large;
+  for (int i = 0; i < 100; ++i) {
+    large.append("0123456789"_sv);
+  }
+  const char* large_data = large.view().data();
+  moved                  = move(large);
+  mRequire(moved.view().size() == 1000);
+  mRequire(moved.view().data() == large_data);
+  mRequire(large.view().empty());
+
+  large.append('x');
+  mRequire(large.view() == "x"_sv);
+}
+
+mTestCase(str_builder_to_string) {
+  StrBuilder builder;
+  builder.append("short"_sv);
+  mRequire(builder.to_string() == "short"_sv);
+
+  builder.reset();
+  for (int i = 0; i < 10'000; ++i) {
+    builder.appendf("%04d", i % 10'000);
+  }
+  const char* data = builder.view().data();
+  Str         str  = builder.to_string();
+  mRequire(str.data() == data);  // heap buffer is handed over, not copied
+  mRequire(str.size() == 40'000);
+  mRequire(str.sub(0, 8) == "00000001"_sv);
+  mRequire(builder.view().empty());
+  builder.append("again"_sv);
+  mRequire(builder.to_string() == "again"_sv);
+}
+
+mBenchCase(bench_str_builder) {
+  constexpr size_t count = 1'000'000;
+
+  auto       begin = Time::now();
+  StrBuilder builder;
+  for (size_t i = 0; i < count; ++i) {
+    builder.append("0123456789abcdef"_sv);
+  }
+  Str result = builder.to_string();
+  bench_report("str builder, 16 MB in 16 byte appends"_sv, count, Time::now() - begin);
+  bench_keep(result.size());
+
+  begin = Time::now();
+  Str appended;
+  for (size_t i = 0; i < count; ++i) {
+    appended += "0123456789abcdef"_sv;
+  }
+  bench_report("str +=, 16 MB in 16 byte appends"_sv, count, Time::now() - begin);
+  bench_keep(appended.size());
+}
+
+mBenchCase(bench_str_search) {
+  constexpr size_t size   = 8 * 1024 * 1024;
+  constexpr size_t rounds = 10;
+
+  u64 state = 0x9e3779b97f4a7c15ull;
+  Str text  = random_text(size, state, "abcdefghijklmnopqrstuvwxyz ,.;"_sv);
+  // needles are only at the very end, every search scans whole buffer
+  memcpy(text.data() + size - 9, "#needle!", 8);
+  StrView view = text;
+  size_t  sum  = 0;
+
+  auto begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t i = 0; i < size; ++i) {
+      if (view[i] == '#') {
+        sum += i;
+        break;
+      }
+    }
+  }
+  bench_report("find char, byte loop"_sv, size * rounds, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    sum += view.find('#');
+  }
+  bench_report("find char, simd"_sv, size * rounds, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    for (size_t i = 0; i + 8 <= size; ++i) {
+      if (view.sub(i, 8) == "#needle!"_sv) {
+        sum += i;
+        break;
+      }
+    }
+  }
+  bench_report("find str, sub compare loop"_sv, size * rounds, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    sum += view.find("#needle!"_sv);
+  }
+  bench_report("find str, first/last filter"_sv, size * rounds, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    sum += naive_find_any_of(view, "#!"_sv);
+  }
+  bench_report("find any of 2, byte loop"_sv, size * rounds, Time::now() - begin);
+
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    sum += view.find_any_of("#!"_sv);
+  }
+  bench_report("find any of 2, simd"_sv, size * rounds, Time::now() - begin);
+
+  StrView parts[64];
+  begin = Time::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    sum += view.split("#needle"_sv, parts).size();
+  }
+  bench_report("split by str"_sv, size * rounds, Time::now() - begin);
+  bench_keep(sum);
+}
@@ -137,3 +137,801 @@ mTestCase(threads_cv) {
   Thread waiter{new ThreadFuncWaiter{mutex, cv, ready}};
   Thread notify{new ThreadFuncNotify{mutex, cv, ready}};
 }
+
+namespace {
+  struct PoolCounter {
+    AtomicInt value = 0;
+  };
+
+  void pool_inc(void* arg) {
+    ++((PoolCounter*)arg)->value;
+  }
+
+  struct PoolTree {
+    ThreadPool*  pool;
+    PoolCounter* counter;
+    int          depth;
+  };
+
+  // submits two subtasks from inside of a task and waits for them
+  void pool_tree(void* arg) {
+    auto& tree = *(PoolTree*)arg;
+    ++tree.counter->value;
+    if (tree.depth == 0) {
+      return;
+    }
+    PoolTree left{tree.pool, tree.counter, tree.depth - 1};
+    PoolTree right{tree.pool, tree.counter, tree.depth - 1};
+    auto     left_task  = tree.pool->submit(pool_tree, &left);
+    auto     right_task = tree.pool->submit(pool_tree, &right);
+    tree.pool->wait(left_task);
+    tree.pool->wait(right_task);
+  }
+
+  void pool_throw(void*) {
+    throw 42;
+  }
+
+  struct PoolFan {
+    ThreadPool*  pool;
+    PoolCounter* counter;
+  };
+
+  // submits subtasks from inside of a task without waiting, so they get stolen
+  void pool_fan(void* arg) {
+    auto& fan = *(PoolFan*)arg;
+    for (int i = 0; i < 8; ++i) {
+      fan.pool->submit(pool_inc, fan.counter);
+    }
+  }
+
+  struct PoolRendezvous {
+    Latch arrived;
+    Latch done{1};
+  };
+
+  // occupies a worker until every worker has arrived
+  void pool_rendezvous(void* arg) {
+    auto& rendezvous = *(PoolRendezvous*)arg;
+    rendezvous.arrived.count_down();
+    rendezvous.done.wait_for(Time::make_secs(10));
+  }
+}  // namespace
+
+mTestCase(threads_pool_submit) {
+  ThreadPool& pool = ThreadPool::global();
+  mRequire(pool.workers_count() >= 1);
+
+  PoolCounter                 counter;
+  Arr<ThreadPool::TaskHandle> tasks;
+  for (int i = 0; i < 1000; ++i) {
+    tasks.push(pool.submit(pool_inc, &counter));
+  }
+  for (auto& task : tasks) {
+    pool.wait(task);
+    mRequire(!task.is_valid());
+  }
+  mRequire(counter.value.load() == 1000);
+}
+
+mTestCase(threads_pool_nested) {
+  for (size_t workers : {size_t(1), size_t(4)}) {
+    ThreadPool  pool(workers);
+    PoolCounter counter;
+    PoolTree    root{&pool, &counter, 10};
+    auto        task = pool.submit(pool_tree, &root);
+    pool.wait(task);
+    mRequire(counter.value.load() == (1 << 11) - 1);
+  }
+}
+
+mTestCase(threads_pool_workers_stay) {
+  constexpr int fans    = 200000;
+  constexpr int workers = 8;
+
+  ThreadPool pool(workers);
+  for (int round = 0; round < 4; ++round) {
+    PoolCounter counter;
+    PoolFan     fan{&pool, &counter};
+    for (int i = 0; i < fans; ++i) {
+      pool.submit(pool_fan, &fan);  // handle is dropped
+    }
+    Time deadline = Time::now() + Time::make_secs(30);
+    while (counter.value.load() != fans * 8 && Time::now() < deadline) {
+      Thread::sleep(Time::make_ms(1));
+    }
+    mRequire(counter.value.load() == fans * 8);
+
+    // every worker must still be alive to take one of these, caller does not help
+    PoolRendezvous rendezvous{Latch(workers)};
+    for (int i = 0; i < workers; ++i) {
+      pool.submit(pool_rendezvous, &rendezvous);
+    }
+    bool all_arrived = rendezvous.arrived.wait_for(Time::make_secs(10));
+    rendezvous.done.count_down();
+    mRequire(all_arrived);
+  }
+}
+
+mTestCase(threads_pool_task_throws) {
+  ThreadPool  pool(2);
+  PoolCounter counter;
+  for (int i = 0; i < 10; ++i) {
+    auto failing = pool.submit(pool_throw, nullptr);
+    auto task    = pool.submit(pool_inc, &counter);
+    pool.wait(failing);
+    pool.wait(task);
+  }
+  mRequire(counter.value.load() == 10);
+}
+
+mTestCase(threads_pool_detach) {
+  PoolCounter counter;
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 100; ++i) {
+      pool.submit(pool_inc, &counter);  // handle is dropped
+    }
+  }
+  mRequire(counter.value.load() == 100);
+}
+
+mTestCase(threads_atomic) {
+  Atomic<u32> u = 0xF0;
+  mRequire(u.fetch_or(0x0F) == 0xF0);
+  mRequire(u.fetch_and(0x3C) == 0xFF);
+  mRequire(u.fetch_xor(0xFF) == 0x3C);
+  mRequire(u.load() == 0xC3);
+  mRequire(u.exchange(7) == 0xC3);
+  ++u;
+  --u;
+  --u;
+  mRequire(u == 6);
+
+  Atomic<s64> s = -5;
+  mRequire(s.fetch_sub(10) == -5);
+  mRequire(s.fetch_add(20, MemoryOrder::Relaxed) == -15);
+  s64 expected = 0;
+  mRequire(!s.compare_exchange_strong(expected, 1));
+  mRequire(expected == 5);
+  while (!s.compare_exchange_weak(expected, 1)) {
+  }
+  mRequire(s.load(MemoryOrder::Relaxed) == 1);
+
+  Atomic<u64> big = ~u64(0) - 1;
+  ++big;
+  mRequire(big == ~u64(0));
+
+  int          values[4] = {10, 20, 30, 40};
+  Atomic<int*> ptr       = values;
+  mRequire(ptr.fetch_add(2) == values);
+  mRequire(*ptr.load() == 30);
+  ++ptr;
+  mRequire(*ptr.load() == 40);
+  mRequire(ptr.fetch_sub(3) == values + 3);
+  mRequire(ptr.exchange(nullptr) == values);
+
+  Atomic<bool> flag;
+  mRequire(!flag.load());
+  mRequire(!flag.exchange(true, MemoryOrder::AcquireRelease));
+  bool was = false;
+  mRequire(!flag.compare_exchange_strong(was, false, MemoryOrder::Release));
+  mRequire(was);
+  atomic_thread_fence(MemoryOrder::SequentialConsistency);
+  atomic_signal_fence(MemoryOrder::Acquire);
+
+  static_assert(sizeof(Atomic<u32>) == sizeof(u32));
+  static_assert(sizeof(Atomic<u32, g_cache_line_size>) == g_cache_line_size);
+  static_assert(alignof(Atomic<u64, g_cache_line_size>) == g_cache_line_size);
+}
+
+namespace {
+  template <typename TFunc>
+  struct ThreadFuncCall final : ThreadFunc {
+    TFunc func_;
+
+    explicit ThreadFuncCall(TFunc func) : func_(move(func)) {}
+    ~ThreadFuncCall() override = default;
+
+    void run() override { func_(); }
+  };
+
+  template <typename TFunc>
+  UPtr<ThreadFunc> make_thread_func(TFunc func) {
+    return UPtr<ThreadFunc>(new ThreadFuncCall<TFunc>(move(func)));
+  }
+
+  constexpr u64 g_queue_producers = 4;
+  constexpr u64 g_queue_messages  = 20'000;
+}  // namespace
+
+mTestCase(threads_mpmc_queue) {
+  MpmcQueue<Str> queue(5);
+  mRequire(queue.capacity() == 8);
+
+  Str value;
+  mRequire(!queue.try_pop(value));
+  for (int i = 0; i < 8; ++i) {
+    mRequire(queue.try_push(fmt(i)));
+  }
+  Str extra = "extra"_s;
+  mRequire(!queue.try_push(move(extra)));
+  mRequire(extra == "extra"_sv);
+  for (int i = 0; i < 3; ++i) {
+    mRequire(queue.try_pop(value));
+    mRequire(value == fmt(i));
+  }
+
+  Arr<Str> batch{"a"_s, "b"_s, "c"_s, "d"_s};
+  mRequire(queue.try_push_batch(batch) == 3);
+  mRequire(batch[3] == "d"_sv);
+
+  Arr<Str> out(6);
+  mRequire(queue.try_pop_batch(out) == 6);
+  mRequire(out[0] == "3"_sv);
+  mRequire(out[4] == "7"_sv);
+  mRequire(out[5] == "a"_sv);
+  mRequire(queue.try_push(out[0]));  // values left in queue are destroyed with it
+}
+
+mTestCase(threads_mpmc_threads) {
+  MpmcQueue<u64> queue(1024);
+  Atomic<u64>    popped_count = 0;
+  Atomic<u64>    popped_sum   = 0;
+  Atomic<u64>    order_errors = 0;
+
+  Arr<Thread> threads;
+  for (u64 p = 0; p < g_queue_producers; ++p) {
+    threads.emplace(make_thread_func([&queue, p] {
+      u64 batch[16];
+      for (u64 i = 0; i < g_queue_messages;) {
+        if (i % 3 == 0) {
+          size_t count = mMin(u64(mArrSize(batch)), g_queue_messages - i);
+          for (size_t j = 0; j < count; ++j) {
+            batch[j] = p * g_queue_messages + i + j;
+          }
+          ArrView<u64> rest(batch, count);
+          while (rest.size() > 0) {
+            size_t pushed = queue.try_push_batch(rest);
+            rest          = rest.sub(pushed);
+          }
+          i += count;
+        } else if (queue.try_push(p * g_queue_messages + i)) {
+          ++i;
+        }
+      }
+    }));
+  }
+  for (u64 c = 0; c < g_queue_producers; ++c) {
+    threads.emplace(make_thread_func([&] {
+      u64 last[g_queue_producers] = {};
+      u64 buffer[8];
+      while (popped_count.load() < g_queue_producers * g_queue_messages) {
+        size_t count = queue.try_pop_batch(ArrView<u64>(buffer, mArrSize(buffer)));
+        for (size_t i = 0; i < count; ++i) {
+          u64 producer = buffer[i] / g_queue_messages;
+          u64 index    = buffer[i] % g_queue_messages + 1;
+          if (index <= last[producer]) {
+            ++order_errors;
+          }
+          last[producer] = index;
+          popped_sum.fetch_add(buffer[i]);
+        }
+        popped_count.fetch_add(count);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  u64 total = g_queue_producers * g_queue_messages;
+  mRequire(popped_count.load() == total);
+  mRequire(popped_sum.load() == total * (total - 1) / 2);
+  mRequire(order_errors.load() == 0);
+}
+
+mTestCase(threads_spsc_ring) {
+  SpscRing<Str> ring(3);
+  mRequire(ring.capacity() == 4);
+
+  Str value;
+  mRequire(!ring.try_pop(value));
+  for (int i = 0; i < 4; ++i) {
+    mRequire(ring.try_push(fmt(i)));
+  }
+  mRequire(!ring.try_push("extra"_s));
+  mRequire(ring.try_pop(value));
+  mRequire(value == "0"_sv);
+
+  Arr<Str> out(8);
+  mRequire(ring.try_pop_batch(out) == 3);
+  mRequire(out[2] == "3"_sv);
+
+  Arr<Str> batch{"a"_s, "b"_s, "c"_s, "d"_s, "e"_s};
+  mRequire(ring.try_push_batch(batch) == 4);
+  mRequire(batch[4] == "e"_sv);
+
+  SpscRing<u64> numbers(256);
+  Thread        producer{make_thread_func([&numbers] {
+    u64 batch[5];
+    for (u64 i = 0; i < g_queue_messages;) {
+      size_t count = mMin(u64(mArrSize(batch)), g_queue_messages - i);
+      for (size_t j = 0; j < count; ++j) {
+        batch[j] = i + j;
+      }
+      ArrView<u64> rest(batch, count);
+      while (rest.size() > 0) {
+        rest = rest.sub(numbers.try_push_batch(rest));
+      }
+      i += count;
+    }
+  })};
+
+  bool in_order = true;
+  for (u64 expected = 0; expected < g_queue_messages;) {
+    u64 got = 0;
+    if (numbers.try_pop(got)) {
+      in_order = in_order && got == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+  mRequire(in_order);
+}
+
+namespace {
+  template <size_t alignment>
+  struct BenchCounters {
+    Atomic<u64, alignment> values[4];
+  };
+
+  template <size_t alignment>
+  struct ThreadFuncCount final : ThreadFunc {
+    Atomic<u64, alignment>& counter_;
+
+    explicit ThreadFuncCount(Atomic<u64, alignment>& counter) : counter_(counter) {}
+    ~ThreadFuncCount() override = default;
+
+    void run() override {
+      for (size_t i = 0; i < size_t(10'000'000); ++i) {
+        counter_.fetch_add(1, MemoryOrder::Relaxed);
+      }
+    }
+  };
+
+  template <size_t alignment>
+  void bench_counters(StrView name) {
+    BenchCounters<alignment> counters;
+    Arr<Thread>              threads(mArrSize(counters.values));
+
+    auto begin = Time::now();
+    for (size_t i = 0; i < threads.size(); ++i) {
+      threads[i].start(new ThreadFuncCount<alignment>(counters.values[i]));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    bench_report(name, threads.size() * 10'000'000, Time::now() - begin);
+  }
+}  // namespace
+
+mBenchCase(bench_atomic_counters) {
+  bench_counters<alignof(u64)>("shared cache line"_sv);
+  bench_counters<g_cache_line_size>("padded to cache line"_sv);
+}
+
+namespace {
+  template <bool batch, typename TQueue>
+  void bench_queue(StrView name, TQueue& queue, u64 producers) {
+    constexpr u64 messages = 1'000'000;
+    u64           per_one  = messages / producers;
+    Atomic<u64>   popped   = 0;
+
+    auto        begin = Time::now();
+    Arr<Thread> threads;
+    for (u64 p = 0; p < producers; ++p) {
+      threads.emplace(make_thread_func([&queue, per_one] {
+        u64 values[32] = {};
+        for (u64 i = 0; i < per_one;) {
+          if constexpr (batch) {
+            i += queue.try_push_batch(
+                ArrView<u64>(values, mMin(u64(mArrSize(values)), per_one - i)));
+          } else if (queue.try_push(i)) {
+            ++i;
+          }
+        }
+      }));
+    }
+    for (u64 c = 0; c < producers; ++c) {
+      threads.emplace(make_thread_func([&queue, &popped, per_one, producers] {
+        u64 values[32];
+        while (popped.load(MemoryOrder::Relaxed) < per_one * producers) {
+          if constexpr (batch) {
+            popped.fetch_add(queue.try_pop_batch(ArrView<u64>(values, mArrSize(values))),
+                             MemoryOrder::Relaxed);
+          } else if (queue.try_pop(values[0])) {
+            popped.fetch_add(1, MemoryOrder::Relaxed);
+          }
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    bench_report(name, per_one * producers, Time::now() - begin);
+  }
+
+  // baseline: ring guarded by mutex
+  struct MutexQueue {
+    Mutex    mutex;
+    Arr<u64> values;
+    size_t   head = 0;
+    size_t   size = 0;
+
+    explicit MutexQueue(size_t capacity) : values(capacity) {}
+
+    bool try_push(u64 value) {
+      LockGuard lock{mutex};
+      if (size == values.size()) {
+        return false;
+      }
+      values[(head + size++) % values.size()] = value;
+      return true;
+    }
+
+    bool try_pop(u64& value) {
+      LockGuard lock{mutex};
+      if (size == 0) {
+        return false;
+      }
+      value = values[head];
+      head  = (head + 1) % values.size();
+      --size;
+      return true;
+    }
+  };
+}  // namespace
+
+mBenchCase(bench_queues) {
+  {
+    MutexQueue queue(1024);
+    bench_queue<false>("mutex queue, 1:1"_sv, queue, 1);
+  }
+  {
+    SpscRing<u64> ring(1024);
+    bench_queue<false>("spsc ring, 1:1"_sv, ring, 1);
+  }
+  {
+    SpscRing<u64> ring(1024);
+    bench_queue<true>("spsc ring batch, 1:1"_sv, ring, 1);
+  }
+  {
+    MpmcQueue<u64> queue(1024);
+    bench_queue<false>("mpmc queue, 1:1"_sv, queue, 1);
+  }
+  {
+    MpmcQueue<u64> queue(1024);
+    bench_queue<false>("mpmc queue, 4:4"_sv, queue, 4);
+  }
+  {
+    MpmcQueue<u64> queue(1024);
+    bench_queue<true>("mpmc queue batch, 4:4"_sv, queue, 4);
+  }
+  {
+    MutexQueue queue(1024);
+    bench_queue<false>("mutex queue, 4:4"_sv, queue, 4);
+  }
+}
+
+namespace {
+  template <typename TMutex>
+  u64 count_with_lock(size_t threads_count, u64 per_thread) {
+    TMutex      mutex;
+    u64         counter = 0;
+    Arr<Thread> threads;
+    for (size_t i = 0; i < threads_count; ++i) {
+      threads.emplace(make_thread_func([&] {
+        for (u64 j = 0; j < per_thread; ++j) {
+          LockGuard lock{mutex};
+          ++counter;
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    return counter;
+  }
+}  // namespace
+
+mTestCase(threads_locks) {
+  mRequire(count_with_lock<Mutex>(4, 50'000) == 200'000);
+  mRequire(count_with_lock<SpinMutex>(4, 50'000) == 200'000);
+  mRequire(count_with_lock<AdaptiveMutex>(4, 50'000) == 200'000);
+  mRequire(count_with_lock<RwLock>(4, 50'000) == 200'000);
+
+  SpinMutex spin;
+  mRequire(spin.try_lock());
+  mRequire(!spin.try_lock());
+  spin.unlock();
+
+  AdaptiveMutex adaptive;
+  {
+    LockGuard lock{adaptive};
+    mRequire(!adaptive.try_lock());
+    lock.unlock();
+    mRequire(adaptive.try_lock());
+    adaptive.unlock();
+  }
+  mRequire(adaptive.try_lock());
+  adaptive.unlock();
+
+  RwLock rw;
+  {
+    SharedLockGuard first{rw};
+    SharedLockGuard second{rw};
+    mRequire(rw.try_lock_shared());
+    rw.unlock_shared();
+    mRequire(!rw.try_lock());
+  }
+  mRequire(rw.try_lock());
+  mRequire(!rw.try_lock_shared());
+  rw.unlock();
+}
+
+mTestCase(threads_rw_lock) {
+  RwLock      rw;
+  u64         first  = 0;
+  u64         second = 0;
+  Atomic<u64> torn_reads;
+  Atomic<u64> reads;
+
+  Arr<Thread> threads;
+  for (int i = 0; i < 2; ++i) {
+    threads.emplace(make_thread_func([&] {
+      for (int j = 0; j < 20'000; ++j) {
+        LockGuard lock{rw};
+        ++first;
+        ++second;
+      }
+    }));
+  }
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace(make_thread_func([&] {
+      for (int j = 0; j < 20'000; ++j) {
+        SharedLockGuard lock{rw};
+        if (first != second) {
+          ++torn_reads;
+        }
+        reads.fetch_add(1, MemoryOrder::Relaxed);
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  mRequire(first == 40'000);
+  mRequire(second == 40'000);
+  mRequire(reads.load() == 80'000);
+  mRequire(torn_reads.load() == 0);
+}
+
+namespace {
+  // each thread does `ops` short critical sections, every `write_every`-th is exclusive
+  template <typename TMutex>
+  void bench_lock(StrView name, size_t threads_count, u64 write_every) {
+    constexpr u64 ops   = 200'000;
+    TMutex        mutex;
+    u64           value = 0;
+
+    auto        begin = Time::now();
+    Arr<Thread> threads;
+    for (size_t i = 0; i < threads_count; ++i) {
+      threads.emplace(make_thread_func([&] {
+        u64 sum = 0;
+        for (u64 j = 0; j < ops; ++j) {
+          if constexpr (requires { mutex.lock_shared(); }) {
+            if (j % write_every != 0) {
+              SharedLockGuard lock{mutex};
+              sum += value;
+              continue;
+            }
+          }
+          LockGuard lock{mutex};
+          sum += ++value;
+        }
+        bench_keep(sum);
+      }));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    bench_report(fmt(name, ", threads: ", threads_count), threads_count * ops,
+                 Time::now() - begin);
+  }
+}  // namespace
+
+mBenchCase(bench_locks) {
+  for (size_t threads : {size_t(1), size_t(4)}) {
+    bench_lock<Mutex>("Mutex"_sv, threads, 1);
+    bench_lock<SpinMutex>("SpinMutex"_sv, threads, 1);
+    bench_lock<AdaptiveMutex>("AdaptiveMutex"_sv, threads, 1);
+    bench_lock<RwLock>("RwLock, writes only"_sv, threads, 1);
+    bench_lock<RwLock>("RwLock, 1/16 writes"_sv, threads, 16);
+  }
+}
+
+mTestCase(threads_cv_wait_for) {
+  Mutex             mutex;
+  ConditionVariable cv;
+  bool              ready = false;
+
+  {
+    LockGuard lock{mutex};
+    auto      begin = Time::now();
+    mRequire(!cv.wait_for(mutex, Time::make_ms(20), [&] { return ready; }));
+    mRequire((Time::now() - begin).ms() >= 19);
+  }
+
+  Thread notify{make_thread_func([&] {
+    Thread::sleep(Time::make_ms(10));
+    LockGuard lock{mutex};
+    ready = true;
+    cv.notify_all();
+  })};
+  {
+    LockGuard lock{mutex};
+    mRequire(cv.wait_for(mutex, Time::make_secs(10), [&] { return ready; }));
+  }
+  notify.join();
+
+  ready = false;
+  Thread notify_again{make_thread_func([&] {
+    LockGuard lock{mutex};
+    ready = true;
+    cv.notify_one();
+  })};
+  {
+    LockGuard lock{mutex};
+    cv.wait(mutex, [&] { return ready; });
+  }
+}
+
+mTestCase(threads_negative_timeout) {
+  // negative timeout is zero timeout: waits time out at once
+  Time negative = Time::make_ms(-50);
+  auto begin    = Time::now();
+
+  Mutex             mutex;
+  ConditionVariable cv;
+  {
+    LockGuard lock{mutex};
+    cv.wait_for(mutex, negative);
+  }
+  Atomic<u32> value = 0;
+  mRequire(!futex_wait(value, 0, negative));
+  Semaphore semaphore;
+  mRequire(!semaphore.try_acquire_for(negative));
+  Latch latch(1);
+  mRequire(!latch.wait_for(negative));
+  Event event;
+  mRequire(!event.wait_for(negative));
+
+  mRequire((Time::now() - begin).secs() < 5);
+}
+
+mTestCase(threads_semaphore) {
+  Semaphore semaphore(2);
+  mRequire(semaphore.try_acquire());
+  mRequire(semaphore.try_acquire());
+  mRequire(!semaphore.try_acquire());
+  mRequire(!semaphore.try_acquire_for(Time::make_ms(5)));
+
+  Atomic<u64> consumed;
+  Arr<Thread> consumers;
+  for (int i = 0; i < 4; ++i) {
+    consumers.emplace(make_thread_func([&] {
+      for (int j = 0; j < 1000; ++j) {
+        semaphore.acquire();
+        ++consumed;
+      }
+    }));
+  }
+  for (int i = 0; i < 2000; ++i) {
+    semaphore.release(2);
+  }
+  for (auto& thread : consumers) {
+    thread.join();
+  }
+  mRequire(consumed.load() == 4000);
+  mRequire(!semaphore.try_acquire());
+}
+
+mTestCase(threads_latch) {
+  Latch timeout_latch(1);
+  mRequire(!timeout_latch.try_wait());
+  mRequire(!timeout_latch.wait_for(Time::make_ms(5)));
+  timeout_latch.count_down();
+  mRequire(timeout_latch.wait_for(Time::make_ms(5)));
+
+  Latch       started(5);
+  Latch       done(4);
+  Atomic<u64> work;
+  Arr<Thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace(make_thread_func([&] {
+      started.arrive_and_wait();
+      ++work;
+      done.count_down();
+    }));
+  }
+  mRequire(work.load() == 0);
+  started.arrive_and_wait();
+  done.wait();
+  mRequire(work.load() == 4);
+}
+
+mTestCase(threads_barrier) {
+  constexpr u32 threads_count = 4;
+  constexpr u32 phases        = 200;
+
+  Barrier     barrier(threads_count);
+  Atomic<u32> arrived;
+  Atomic<u32> last_count;
+  Atomic<u32> errors;
+  Arr<Thread> threads;
+  for (u32 i = 0; i < threads_count; ++i) {
+    threads.emplace(make_thread_func([&] {
+      for (u32 phase = 0; phase < phases; ++phase) {
+        ++arrived;
+        if (barrier.arrive_and_wait()) {
+          ++last_count;
+        }
+        if (arrived.load() < (phase + 1) * threads_count) {
+          ++errors;
+        }
+        barrier.arrive_and_wait();  // nobody starts next phase before all have checked
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  mRequire(errors.load() == 0);
+  mRequire(arrived.load() == phases * threads_count);
+  mRequire(last_count.load() == phases);
+}
+
+mTestCase(threads_event) {
+  Event event;
+  mRequire(!event.try_wait());
+  mRequire(!event.wait_for(Time::make_ms(5)));
+  event.set();
+  event.set();  // not counted
+  mRequire(event.wait_for(Time::make_ms(5)));
+  mRequire(!event.try_wait());
+
+  Event initially_set(true);
+  initially_set.wait();
+
+  // ping-pong
+  Event  ping;
+  Event  pong;
+  u64    value = 0;
+  Thread other{make_thread_func([&] {
+    for (int i = 0; i < 1000; ++i) {
+      ping.wait();
+      ++value;
+      pong.set();
+    }
+  })};
+  bool in_step = true;
+  for (u64 i = 0; i < 1000; ++i) {
+    ping.set();
+    pong.wait();
+    in_step = in_step && value == i + 1;
+  }
+  other.join();
+  mRequire(in_step);
+}
@@ -1,25 +1,472 @@
 #pragma once
 #include "cc/common.hpp"
 #include "cc/arr-view.hpp"
+#include "cc/arr.hpp"
 
-// TODO: this is bubble sort, not very cache friendly, need insertion sort
-template <typename T, typename TFunc>
-void sort(ArrView<T> arr, TFunc&& compare_func) {
-  if (arr.empty() || arr.size() == 1) {
-    return;
+// Sorting. sort() is pattern-defeating quicksort (https://github.com/orlp/pdqsort):
+// quicksort with insertion sort for small partitions, heapsort fallback for bad pivots,
+// O(n) on sorted and reversed inputs. Integer and StrHash arrays sorted with default
+// order take LSD radix sort path.
+
+namespace details {
+  template <typename T>
+  using SortFunc = bool (*)(const T&, const T&);
+
+  constexpr size_t g_sort_insertion_threshold     = 24;
+  constexpr size_t g_sort_ninther_threshold       = 128;
+  constexpr size_t g_sort_partial_insertion_limit = 8;
+  constexpr size_t g_sort_radix_threshold         = 1024;
+  constexpr size_t g_stable_sort_run_size         = 32;
+
+  inline size_t sort_log2(size_t n) {
+    size_t log = 0;
+    while (n >>= 1) {
+      ++log;
+    }
+    return log;
   }
-  for (size_t i = 0; i < arr.size(); ++i) {
-    bool swapped = false;
-    for (size_t j = 0; j < arr.size() - i - 1; ++j) {
-      if (compare_func(arr[j + 1], arr[j])) {
-        swapped = true;
-        swap(arr[j], arr[j + 1]);
+
+  template <typename T, typename TFunc>
+  void insertion_sort(T* begin, T* end, TFunc& comp) {
+    if (begin == end) {
+      return;
+    }
+    for (T* cur = begin + 1; cur != end; ++cur) {
+      T* sift   = cur;
+      T* sift_1 = cur - 1;
+      if (comp(*sift, *sift_1)) {
+        T tmp = move(*sift);
+        do {
+          *sift-- = move(*sift_1);
+        } while (sift != begin && comp(tmp, *--sift_1));
+        *sift = move(tmp);
       }
     }
-    if (!swapped) {  // array is sorted
+  }
+
+  // Requires element before begin to be not greater than any element in range.
+  template <typename T, typename TFunc>
+  void unguarded_insertion_sort(T* begin, T* end, TFunc& comp) {
+    if (begin == end) {
       return;
     }
+    for (T* cur = begin + 1; cur != end; ++cur) {
+      T* sift   = cur;
+      T* sift_1 = cur - 1;
+      if (comp(*sift, *sift_1)) {
+        T tmp = move(*sift);
+        do {
+          *sift-- = move(*sift_1);
+        } while (comp(tmp, *--sift_1));
+        *sift = move(tmp);
+      }
+    }
   }
+
+  // Insertion sort which gives up after limited count of moves.
+  // Returns true when range was sorted.
+  template <typename T, typename TFunc>
+  bool partial_insertion_sort(T* begin, T* end, TFunc& comp) {
+    if (begin == end) {
+      return true;
+    }
+    size_t limit = 0;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+      T* sift   = cur;
+      T* sift_1 = cur - 1;
+      if (comp(*sift, *sift_1)) {
+        T tmp = move(*sift);
+        do {
+          *sift-- = move(*sift_1);
+        } while (sift != begin && comp(tmp, *--sift_1));
+        *sift = move(tmp);
+        limit += size_t(cur - sift);
+      }
+      if (limit > g_sort_partial_insertion_limit) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename T, typename TFunc>
+  void sort2(T* a, T* b, TFunc& comp) {
+    if (comp(*b, *a)) {
+      swap(*a, *b);
+    }
+  }
+
+  template <typename T, typename TFunc>
+  void sort3(T* a, T* b, T* c, TFunc& comp) {
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+  }
+
+  template <typename T, typename TFunc>
+  void heap_sift_down(T* data, size_t root, size_t size, TFunc& comp) {
+    T tmp = move(data[root]);
+    while (true) {
+      size_t child = 2 * root + 1;
+      if (child >= size) {
+        break;
+      }
+      if (child + 1 < size && comp(data[child], data[child + 1])) {
+        ++child;
+      }
+      if (!comp(tmp, data[child])) {
+        break;
+      }
+      data[root] = move(data[child]);
+      root       = child;
+    }
+    data[root] = move(tmp);
+  }
+
+  template <typename T, typename TFunc>
+  void make_heap(T* data, size_t size, TFunc& comp) {
+    for (size_t i = size / 2; i-- > 0;) {
+      heap_sift_down(data, i, size, comp);
+    }
+  }
+
+  template <typename T, typename TFunc>
+  void sort_heap(T* data, size_t size, TFunc& comp) {
+    for (size_t end = size; end > 1; --end) {
+      swap(data[0], data[end - 1]);
+      heap_sift_down(data, 0, end - 1, comp);
+    }
+  }
+
+  template <typename T, typename TFunc>
+  void heap_sort(T* begin, T* end, TFunc& comp) {
+    auto size = size_t(end - begin);
+    make_heap(begin, size, comp);
+    sort_heap(begin, size, comp);
+  }
+
+  // Places `count` smallest elements into [begin, begin + count) in sorted order.
+  template <typename T, typename TFunc>
+  void heap_select_sort(T* begin, T* end, size_t count, TFunc& comp) {
+    if (count == 0) {
+      return;
+    }
+    make_heap(begin, count, comp);
+    for (T* cur = begin + count; cur < end; ++cur) {
+      if (comp(*cur, *begin)) {
+        swap(*cur, *begin);
+        heap_sift_down(begin, 0, count, comp);
+      }
+    }
+    sort_heap(begin, count, comp);
+  }
+
+  // Picks pivot into *begin: median of 3, or pseudo-median of 9 for big ranges.
+  template <typename T, typename TFunc>
+  void choose_pivot(T* begin, T* end, TFunc& comp) {
+    auto size = size_t(end - begin);
+    auto half = size / 2;
+    if (size > g_sort_ninther_threshold) {
+      sort3(begin, begin + half, end - 1, comp);
+      sort3(begin + 1, begin + (half - 1), end - 2, comp);
+      sort3(begin + 2, begin + (half + 1), end - 3, comp);
+      sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+      swap(*begin, *(begin + half));
+    } else {
+      sort3(begin + half, begin, end - 1, comp);
+    }
+  }
+
+  // Partitions around pivot *begin, elements equal to pivot go to the right.
+  // Returns pivot position and whether range was already partitioned.
+  template <typename T, typename TFunc>
+  Pair<T*, bool> partition_right(T* begin, T* end, TFunc& comp) {
+    T  pivot = move(*begin);
+    T* first = begin;
+    T* last  = end;
+
+    // pivot is a median of at least 3 elements, so both loops are guarded
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin) {
+      while (first < last && !comp(*--last, pivot)) {
+      }
+    } else {
+      while (!comp(*--last, pivot)) {
+      }
+    }
+
+    bool already_partitioned = first >= last;
+    while (first < last) {
+      swap(*first, *last);
+      while (comp(*++first, pivot)) {
+      }
+      while (!comp(*--last, pivot)) {
+      }
+    }
+
+    T* pivot_pos = first - 1;
+    *begin       = move(*pivot_pos);
+    *pivot_pos   = move(pivot);
+    return {pivot_pos, already_partitioned};
+  }
+
+  // Partitions around pivot *begin, elements equal to pivot go to the left.
+  // Used when many elements are equal to pivot, they are never touched after.
+  template <typename T, typename TFunc>
+  T* partition_left(T* begin, T* end, TFunc& comp) {
+    T  pivot = move(*begin);
+    T* first = begin;
+    T* last  = end;
+
+    while (comp(pivot, *--last)) {
+    }
+    if (last + 1 == end) {
+      while (first < last && !comp(pivot, *++first)) {
+      }
+    } else {
+      while (!comp(pivot, *++first)) {
+      }
+    }
+
+    while (first < last) {
+      swap(*first, *last);
+      while (comp(pivot, *--last)) {
+      }
+      while (!comp(pivot, *++first)) {
+      }
+    }
+
+    T* pivot_pos = last;
+    *begin       = move(*pivot_pos);
+    *pivot_pos   = move(pivot);
+    return pivot_pos;
+  }
+
+  // Breaks patterns which caused unbalanced partition.
+  template <typename T>
+  void break_patterns(T* begin, T* end, T* pivot_pos) {
+    auto l_size = size_t(pivot_pos - begin);
+    auto r_size = size_t(end - (pivot_pos + 1));
+    if (l_size >= g_sort_insertion_threshold) {
+      swap(begin[0], begin[l_size / 4]);
+      swap(*(pivot_pos - 1), *(pivot_pos - l_size / 4));
+      if (l_size > g_sort_ninther_threshold) {
+        swap(begin[1], begin[l_size / 4 + 1]);
+        swap(begin[2], begin[l_size / 4 + 2]);
+        swap(*(pivot_pos - 2), *(pivot_pos - (l_size / 4 + 1)));
+        swap(*(pivot_pos - 3), *(pivot_pos - (l_size / 4 + 2)));
+      }
+    }
+    if (r_size >= g_sort_insertion_threshold) {
+      swap(pivot_pos[1], pivot_pos[1 + r_size / 4]);
+      swap(*(end - 1), *(end - r_size / 4));
+      if (r_size > g_sort_ninther_threshold) {
+        swap(pivot_pos[2], pivot_pos[2 + r_size / 4]);
+        swap(pivot_pos[3], pivot_pos[3 + r_size / 4]);
+        swap(*(end - 2), *(end - (1 + r_size / 4)));
+        swap(*(end - 3), *(end - (2 + r_size / 4)));
+      }
+    }
+  }
+
+  template <typename T, typename TFunc>
+  void pdq_sort(T* begin, T* end, TFunc& comp, size_t bad_allowed, bool leftmost) {
+    while (true) {
+      auto size = size_t(end - begin);
+
+      if (size < g_sort_insertion_threshold) {
+        if (leftmost) {
+          insertion_sort(begin, end, comp);
+        } else {
+          unguarded_insertion_sort(begin, end, comp);
+        }
+        return;
+      }
+
+      choose_pivot(begin, end, comp);
+
+      // Element before range is equal to pivot: all of the range is not less than it,
+      // so put equal elements to the left and skip them.
+      if (!leftmost && !comp(*(begin - 1), *begin)) {
+        begin = partition_left(begin, end, comp) + 1;
+        continue;
+      }
+
+      auto [pivot_pos, already_partitioned] = partition_right(begin, end, comp);
+
+      auto l_size = size_t(pivot_pos - begin);
+      auto r_size = size_t(end - (pivot_pos + 1));
+
+      if (l_size < size / 8 || r_size < size / 8) {
+        if (--bad_allowed == 0) {
+          heap_sort(begin, end, comp);
+          return;
+        }
+        break_patterns(begin, end, pivot_pos);
+      } else if (already_partitioned && partial_insertion_sort(begin, pivot_pos, comp) &&
+                 partial_insertion_sort(pivot_pos + 1, end, comp)) {
+        return;
+      }
+
+      // recurse into smaller side, loop on bigger one
+      if (l_size < r_size) {
+        pdq_sort(begin, pivot_pos, comp, bad_allowed, leftmost);
+        begin    = pivot_pos + 1;
+        leftmost = false;
+      } else {
+        pdq_sort(pivot_pos + 1, end, comp, bad_allowed, false);
+        end = pivot_pos;
+      }
+    }
+  }
+
+  template <typename T, typename TFunc>
+  void nth_element(T* begin, T* end, T* nth, TFunc& comp) {
+    size_t bad_allowed = sort_log2(size_t(end - begin)) + 1;
+    while (size_t(end - begin) >= g_sort_insertion_threshold) {
+      choose_pivot(begin, end, comp);
+      auto [pivot_pos, _] = partition_right(begin, end, comp);
+      if (pivot_pos == nth) {
+        return;
+      }
+
+      auto size   = size_t(end - begin);
+      auto l_size = size_t(pivot_pos - begin);
+      auto r_size = size_t(end - (pivot_pos + 1));
+      if (l_size < size / 8 || r_size < size / 8) {
+        if (--bad_allowed == 0) {
+          heap_select_sort(begin, end, size_t(nth - begin) + 1, comp);
+          return;
+        }
+        break_patterns(begin, end, pivot_pos);
+      }
+
+      if (nth < pivot_pos) {
+        end = pivot_pos;
+      } else {
+        begin = pivot_pos + 1;
+      }
+    }
+    insertion_sort(begin, end, comp);
+  }
+
+  // Merges sorted [begin, mid) and [mid, end), buffer is empty with enough capacity to
+  // hold left part.
+  template <typename T, typename TFunc>
+  void stable_merge(T* begin, T* mid, T* end, Arr<T>& buffer, TFunc& comp) {
+    if (!comp(*mid, *(mid - 1))) {
+      return;  // already ordered
+    }
+    for (T* cur = begin; cur != mid; ++cur) {
+      buffer.emplace(move(*cur));
+    }
+    T* left     = buffer.begin();
+    T* left_end = buffer.end();
+    T* right    = mid;
+    T* out      = begin;
+    while (left != left_end && right != end) {
+      if (comp(*right, *left)) {
+        *out++ = move(*right++);
+      } else {
+        *out++ = move(*left++);
+      }
+    }
+    while (left != left_end) {
+      *out++ = move(*left++);
+    }
+    buffer.clear();
+  }
+
+  template <typename T, typename TFunc>
+  void stable_sort(T* begin, T* end, Arr<T>& buffer, TFunc& comp) {
+    auto size = size_t(end - begin);
+    if (size <= g_stable_sort_run_size) {
+      insertion_sort(begin, end, comp);
+      return;
+    }
+    T* mid = begin + size / 2;
+    stable_sort(begin, mid, buffer, comp);
+    stable_sort(mid, end, buffer, comp);
+    stable_merge(begin, mid, end, buffer, comp);
+  }
+
+  template <typename T>
+  concept RadixSortable =
+      (std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_same_v<T, StrHash>;
+
+  // Maps value to unsigned key with the same order.
+  template <typename T>
+  auto radix_key(const T& value) {
+    if constexpr (std::is_same_v<T, StrHash>) {
+      return value.hash();
+    } else {
+      using Key = std::make_unsigned_t<T>;
+      if constexpr (std::is_signed_v<T>) {
+        return Key(Key(value) ^ (Key(1) << (sizeof(T) * 8 - 1)));
+      } else {
+        return Key(value);
+      }
+    }
+  }
+
+  template <typename T, typename TKeyFunc>
+  void radix_sort(ArrView<T> arr, TKeyFunc& key_func) {
+    using Key                    = decltype(key_func(arr[0]));
+    constexpr size_t digit_count = sizeof(Key);
+    static_assert(std::is_unsigned_v<Key>, "radix sort key must be unsigned integer");
+
+    if (arr.size() <= 1) {
+      return;
+    }
+
+    // histograms for all digits are collected in one pass
+    auto counts = Arr<size_t>(digit_count * 256);
+    counts.fill(0);
+    for (const T& value : arr) {
+      Key key = key_func(value);
+      for (size_t digit = 0; digit < digit_count; ++digit) {
+        ++counts[digit * 256 + ((key >> (digit * 8)) & 0xff)];
+      }
+    }
+
+    Arr<T> buffer(arr.size());
+    T*     from = arr.data();
+    T*     to   = buffer.data();
+
+    for (size_t digit = 0; digit < digit_count; ++digit) {
+      size_t* digit_counts = counts.data() + digit * 256;
+      Key     first_key    = key_func(from[0]);
+      if (digit_counts[(first_key >> (digit * 8)) & 0xff] == arr.size()) {
+        continue;  // all values have same digit, pass would not change order
+      }
+
+      size_t offset = 0;
+      for (size_t i = 0; i < 256; ++i) {
+        size_t count    = digit_counts[i];
+        digit_counts[i] = offset;
+        offset += count;
+      }
+      for (size_t i = 0; i < arr.size(); ++i) {
+        Key key                                         = key_func(from[i]);
+        to[digit_counts[(key >> (digit * 8)) & 0xff]++] = move(from[i]);
+      }
+      swap(from, to);
+    }
+
+    if (from != arr.data()) {
+      move(ArrView<T>(from, arr.size()), arr);
+    }
+  }
+}  // namespace details
+
+template <typename T, typename TFunc>
+void sort(ArrView<T> arr, TFunc&& compare_func) {
+  if (arr.size() <= 1) {
+    return;
+  }
+  details::pdq_sort(arr.begin(), arr.end(), compare_func,
+                    details::sort_log2(arr.size()) + 1, true);
 }
 
 template <typename T>
@@ -27,7 +474,72 @@ void sort(ArrView<T> arr, bool (*sort_func)(const T&, const T&)) {
   sort<T, decltype(sort_func)>(arr, move(sort_func));
 }
 
+// LSD radix sort by unsigned integer key, stable. Requires trivially copyable T.
+template <typename T, typename TKeyFunc>
+void radix_sort(ArrView<T> arr, TKeyFunc&& key_func) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  details::radix_sort(arr, key_func);
+}
+
+template <details::RadixSortable T>
+void radix_sort(ArrView<T> arr) {
+  radix_sort(arr, details::radix_key<T>);
+}
+
 template <typename T>
 void sort(ArrView<T> arr) {
+  if constexpr (details::RadixSortable<T>) {
+    if (arr.size() >= details::g_sort_radix_threshold) {
+      radix_sort(arr);
+      return;
+    }
+  }
   sort(arr, cc::is_less<T>);
 }
+
+// Sort which keeps order of equal elements. Merge sort, allocates buffer of size / 2.
+template <typename T, typename TFunc>
+void stable_sort(ArrView<T> arr, TFunc&& compare_func) {
+  if (arr.size() <= 1) {
+    return;
+  }
+  Arr<T> buffer;
+  buffer.reserve(arr.size() / 2 + 1);
+  details::stable_sort(arr.begin(), arr.end(), buffer, compare_func);
+}
+
+template <typename T>
+void stable_sort(ArrView<T> arr) {
+  stable_sort<T, details::SortFunc<T>>(arr, cc::is_less<T>);
+}
+
+// Sorts `count` smallest elements into beginning of array, order of the rest is unspecified.
+template <typename T, typename TFunc>
+void partial_sort(ArrView<T> arr, size_t count, TFunc&& compare_func) {
+  count = mMin(count, arr.size());
+  if (count == arr.size()) {
+    sort(arr, compare_func);
+    return;
+  }
+  details::heap_select_sort(arr.begin(), arr.end(), count, compare_func);
+}
+
+template <typename T>
+void partial_sort(ArrView<T> arr, size_t count) {
+  partial_sort<T, details::SortFunc<T>>(arr, count, cc::is_less<T>);
+}
+
+// Puts element which would be at index `nth` in sorted array to its place. Elements
+// before it are not greater, elements after are not less.
+template <typename T, typename TFunc>
+void nth_element(ArrView<T> arr, size_t nth, TFunc&& compare_func) {
+  if (nth >= arr.size()) {
+    return;
+  }
+  details::nth_element(arr.begin(), arr.end(), arr.begin() + nth, compare_func);
+}
+
+template <typename T>
+void nth_element(ArrView<T> arr, size_t nth) {
+  nth_element<T, details::SortFunc<T>>(arr, nth, cc::is_less<T>);
+}
@@ -7,10 +7,13 @@
 #include "cc/arr.hpp"
 #include "cc/str.hpp"
 #include "cc/dict.hpp"
+#include "cc/concurrent-dict.hpp"
 #include "cc/set.hpp"
+#include "cc/small-set.hpp"
 #include "cc/ini.hpp"
 #include "cc/sarr.hpp"
 #include "cc/list.hpp"
+#include "cc/intrusive.hpp"
 
 #include "cc/algo.hpp"
 #include "cc/fmt.hpp"
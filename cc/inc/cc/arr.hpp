@@ -8,16 +8,26 @@ enum class ResizeFlags {
   KeepOld = 1,
 };
 
-// Dynamic array. Requires default ctor for T.
+template <typename T>
+class Arr;
+
+// Splits view into `groups_count` contiguous parts, sizes differ at most by one.
+template <typename T>
+Arr<ArrView<T>> split_into_groups(ArrView<T> view, size_t groups_count);
+
+// Dynamic array over raw storage, values are constructed in place. Default ctor for T is
+// required only by resize() and the size ctor.
+// Storage grows geometrically, so push/emplace/append are amortized O(1).
 template <typename T>
 class Arr : public ArrView<T> {
  protected:
   using ArrView<T>::data_;
   using ArrView<T>::size_;
+  size_t capacity_ = 0;
 
  public:
   Arr() = default;
-  ~Arr() { delete[] data_; }
+  ~Arr() { release(); }
 
   // --- create
 
@@ -28,29 +38,24 @@ class Arr : public ArrView<T> {
 
   // --- copy
 
-  Arr(const Arr& o) {
-    resize(o.size());
-    copy(o, *this);
-  }
+  Arr(const Arr& o) : Arr(ArrView<T>(o)) {}
 
   explicit Arr(ArrView<T> arr) {
-    resize(arr.size());
-    copy(arr, *this);
+    reserve(arr.size());
+    append(arr);
   }
 
   Arr& operator=(const Arr& o) {
     if (this != &o) {
-      resize(o.size(), ResizeFlags::None);
-      copy(o, *this);
+      assign(o);
     }
     return *this;
   }
 
   Arr& operator=(ArrView<T> arr) {
     if (data_ != arr.data()) {
-      assert(!ptr_intersects(data_, size_, arr.data(), arr.size()));
-      resize(arr.size(), ResizeFlags::None);
-      copy(arr, *this);
+      assert(!ptr_intersects(data_, capacity_ * sizeof(T), arr.data(), arr.byte_size()));
+      assign(arr);
     }
     return *this;
   }
@@ -60,84 +65,254 @@ class Arr : public ArrView<T> {
   Arr(Arr&& o) noexcept {
     swap(data_, o.data_);
     swap(size_, o.size_);
+    swap(capacity_, o.capacity_);
   }
 
   Arr& operator=(Arr&& o) noexcept {
     if (this != &o) {
       swap(data_, o.data_);
       swap(size_, o.size_);
+      swap(capacity_, o.capacity_);
     }
     return *this;
   }
 
   // --- misc
 
+  size_t capacity() const { return capacity_; }
+
+  // Exact resize: grows storage to required_size when it does not fit, resizing to zero
+  // releases storage. New values are default constructed.
   Arr& resize(size_t required_size, ResizeFlags flags = ResizeFlags::KeepOld) {
-    data_ = resize_buffer(required_size, flags);
+    if (((int)flags & (int)ResizeFlags::KeepOld) == 0) {
+      destroy_range(0, size_);
+      size_ = 0;
+    }
+    if (required_size == 0) {
+      release();
+      return *this;
+    }
+    if (required_size > capacity_) {
+      realloc_buffer(required_size);
+    }
+    if (required_size < size_) {
+      destroy_range(required_size, size_);
+    } else {
+      for (size_t i = size_; i < required_size; ++i) {
+        new (data_ + i) T;
+      }
+    }
     size_ = required_size;
     return *this;
   }
 
+  // Ensures storage for at least `capacity` elements without changing size.
+  Arr& reserve(size_t capacity) {
+    if (capacity > capacity_) {
+      realloc_buffer(capacity);
+    }
+    return *this;
+  }
+
+  // Destroys values, keeps storage.
+  Arr& clear() {
+    destroy_range(0, size_);
+    size_ = 0;
+    return *this;
+  }
+
+  Arr& shrink_to_fit() {
+    if (size_ == 0) {
+      release();
+    } else if (capacity_ > size_) {
+      realloc_buffer(size_);
+    }
+    return *this;
+  }
+
   Arr& operator+=(const Arr& other) {
-    if (other.size_ > 0) {
-      size_t insert_pos = size_;
-      resize(size_ + other.size_, ResizeFlags::KeepOld);
-      for (auto v : other) {
-        data_[insert_pos++] = v;
+    append(other);
+    return *this;
+  }
+
+  Arr& append(ArrView<T> values) {
+    if (values.empty()) {
+      return *this;
+    }
+    if (size_ + values.size() > capacity_) {
+      // values may point into our own storage, rebase them after reallocation
+      if (ptr_intersects(data_, capacity_ * sizeof(T), values.data(), values.byte_size())) {
+        size_t offset = size_t(values.data() - data_);
+        grow(size_ + values.size());
+        values = ArrView<T>(data_ + offset, values.size());
+      } else {
+        grow(size_ + values.size());
       }
     }
+    copy_construct(data_ + size_, values.data(), values.size());
+    size_ += values.size();
     return *this;
   }
 
   Arr<Arr> split_into_groups(size_t groups_count) const {
-    Arr<Arr> groups(groups_count);
+    Arr<Arr> groups;
+    groups.reserve(groups_count);
+    for (auto group : ::split_into_groups(ArrView<T>(*this), groups_count)) {
+      groups.emplace(group);
+    }
+    return groups;
+  }
+
+  T& push(T value) { return emplace(move(value)); }
 
-    if (groups_count == 0) {
-      return groups;
+  template <typename... Args>
+  T& emplace(Args&&... args) {
+    if (size_ < capacity_) {
+      new (data_ + size_) T(forward<Args>(args)...);
+      return data_[size_++];
+    }
+    // args may reference our own values, so construct before relocating old storage
+    size_t new_capacity = grow_capacity(size_ + 1);
+    T*     new_data     = allocate(new_capacity);
+    try {
+      new (new_data + size_) T(forward<Args>(args)...);
+    } catch (...) {
+      deallocate(new_data);
+      throw;
     }
+    relocate(new_data, data_, size_);
+    deallocate(data_);
+    data_     = new_data;
+    capacity_ = new_capacity;
+    return data_[size_++];
+  }
 
-    size_t group_size    = size_ / groups_count;
-    size_t remainder     = size_ % groups_count;
-    size_t start         = 0;
-    size_t current_group = 0;
+ private:
+  static constexpr size_t min_grow_capacity = 4;
 
-    for (size_t i = 0; i < groups_count; ++i) {
-      size_t current_group_size = group_size + (i < remainder ? 1 : 0);
-      groups[current_group++]   = this->sub(start, current_group_size);
-      start += current_group_size;
+  size_t grow_capacity(size_t required_capacity) const {
+    return mMax(mMax(capacity_ * 2, min_grow_capacity), required_capacity);
+  }
+
+  void grow(size_t required_capacity) { realloc_buffer(grow_capacity(required_capacity)); }
+
+  void assign(ArrView<T> values) {
+    destroy_range(0, size_);
+    size_ = 0;
+    if (values.size() > capacity_) {
+      realloc_buffer(values.size());
     }
+    copy_construct(data_, values.data(), values.size());
+    size_ = values.size();
+  }
 
-    return groups;
+  void destroy_range(size_t from, size_t to) {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = from; i < to; ++i) {
+        data_[i].~T();
+      }
+    }
   }
 
-  // very unoptimized push back. anyway it is nice to have
-  void push(T value) {
-    resize(size_ + 1, ResizeFlags::KeepOld);
-    data_[size_ - 1] = move(value);
+  void release() {
+    destroy_range(0, size_);
+    deallocate(data_);
+    data_     = nullptr;
+    size_     = 0;
+    capacity_ = 0;
   }
 
- private:
-  T* resize_buffer(size_t required_size, ResizeFlags flags);
+  void realloc_buffer(size_t new_capacity);
+
+  static T*   allocate(size_t count);
+  static void deallocate(T* data);
+  static void relocate(T* to, T* from, size_t count);
+  static void copy_construct(T* to, const T* from, size_t count);
+};
+
+template <typename T>
+struct TriviallyRelocatable<Arr<T>> {
+  static constexpr bool value = true;
 };
 
 // --- details
 
 template <typename T>
-T* Arr<T>::resize_buffer(size_t required_size, ResizeFlags flags) {
-  if (required_size == size_) {
-    return data_;
-  }
-  if (required_size == 0) {
-    delete[] data_;
-    return nullptr;
-  }
-  auto* new_data = new T[required_size];
-  if (size_t move_count = mMin(size_, required_size);
-      move_count && ((int)flags & (int)ResizeFlags::KeepOld) != 0) {
-    auto from = ArrView(data_, move_count);
-    auto to   = ArrView(new_data, move_count);
-    move(from, to);
-  }
-  delete[] data_;
-  return new_data;
+Arr<ArrView<T>> split_into_groups(ArrView<T> view, size_t groups_count) {
+  Arr<ArrView<T>> groups;
+  if (groups_count == 0) {
+    return groups;
+  }
+  groups.reserve(groups_count);
+
+  size_t group_size = view.size() / groups_count;
+  size_t remainder  = view.size() % groups_count;
+  size_t start      = 0;
+
+  for (size_t i = 0; i < groups_count; ++i) {
+    size_t current_group_size = group_size + (i < remainder ? 1 : 0);
+    groups.push(view.sub(start, current_group_size));
+    start += current_group_size;
+  }
+
+  return groups;
+}
+
+template <typename T>
+void Arr<T>::realloc_buffer(size_t new_capacity) {
+  assert(new_capacity >= size_);
+  T* new_data = allocate(new_capacity);
+  relocate(new_data, data_, size_);
+  deallocate(data_);
+  data_     = new_data;
+  capacity_ = new_capacity;
+}
+
+template <typename T>
+T* Arr<T>::allocate(size_t count) {
+  assert(count > 0);
+  if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+  } else {
+    return static_cast<T*>(::operator new(count * sizeof(T)));
+  }
+}
+
+template <typename T>
+void Arr<T>::deallocate(T* data) {
+  if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ::operator delete(data, std::align_val_t(alignof(T)));
+  } else {
+    ::operator delete(data);
+  }
+}
+
+// Moves values into uninitialized storage, source storage is left uninitialized.
+template <typename T>
+void Arr<T>::relocate(T* to, T* from, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  if constexpr (is_trivially_relocatable<T>) {
+    memcpy((void*)to, (const void*)from, count * sizeof(T));
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      new (to + i) T(move(from[i]));
+      from[i].~T();
+    }
+  }
+}
+
+template <typename T>
+void Arr<T>::copy_construct(T* to, const T* from, size_t count) {
+  if (count == 0) {
+    return;
+  }
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    memcpy((void*)to, (const void*)from, count * sizeof(T));
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      new (to + i) T(from[i]);
+    }
+  }
 }
@@ -116,6 +116,23 @@ void swap(T& a, T& b) noexcept {
   b = move(c);
 }
 
+// Type is trivially relocatable when moving its bytes to new storage and forgetting the
+// old ones is the same as move construct + destroy. Containers relocate such types with
+// memcpy.
+template <class T>
+struct TriviallyRelocatable {
+  static constexpr bool value = std::is_trivially_copyable_v<T>;
+};
+
+template <class T>
+constexpr bool is_trivially_relocatable = TriviallyRelocatable<T>::value;
+
+#define mTriviallyRelocatable(T)          \
+  template <>                             \
+  struct TriviallyRelocatable<T> {        \
+    static constexpr bool value = true;   \
+  };
+
 template <typename T>
 concept Equatable = requires(T t) {
   { t == t };  // Has operator==
@@ -139,6 +156,15 @@ concept Hashable = requires(T t) {
 template <class T>
 concept PointerType = std::is_pointer_v<T>;
 
+// Other type to look up TKey in hash containers: hashes the same as equal key and
+// compares equal to it, e.g. StrView for Str. Numbers convert to the key type instead.
+template <typename TLookup, typename TKey>
+concept LookupKey =
+    !std::is_same_v<TLookup, TKey> && !std::is_arithmetic_v<TLookup> &&
+    Hashable<TLookup> && requires(const TKey& key, const TLookup& lookup) {
+      { key == lookup };
+    };
+
 enum class ComparePos {
   Less,
   Equals,
@@ -274,6 +300,11 @@ class UPtr {
   T* operator->() const noexcept { return ptr_; }
 };
 
+template <class T, class TDeleter>
+struct TriviallyRelocatable<UPtr<T, TDeleter>> {
+  static constexpr bool value = true;
+};
+
 // Raw movable pointer via swapping.
 template <class T>
 class RPtr {
@@ -314,3 +345,8 @@ class RPtr {
   T* operator->() const { return ptr_; }
   T& operator*() const { return *ptr_; }
 };
+
+template <class T>
+struct TriviallyRelocatable<RPtr<T>> {
+  static constexpr bool value = true;
+};
@@ -0,0 +1,126 @@
+#pragma once
+#include "cc/dict.hpp"
+#include "cc/threads.hpp"
+
+// Dict for concurrent access: keys are striped across `shard_count` Dict shards by hash,
+// each shard is guarded by its own RwLock. Lookups take shared lock, so readers of the
+// same shard do not block each other, writers only block their own shard. Values are
+// accessed in callbacks called under shard lock, callbacks must not access the same
+// ConcurrentDict.
+template <typename TKey, typename TValue, size_t shard_count = 64>
+class ConcurrentDict final {
+  static_assert(shard_count > 0 && (shard_count & (shard_count - 1)) == 0,
+                "shard count must be power of two");
+
+ public:
+  using Key   = TKey;
+  using Value = TValue;
+  using Shard = Dict<TKey, TValue>;
+
+  ConcurrentDict() = default;
+
+  ConcurrentDict(const ConcurrentDict&)            = delete;
+  ConcurrentDict& operator=(const ConcurrentDict&) = delete;
+
+  // Inserts or replaces value for key.
+  void insert(TKey&& key, TValue&& value) {
+    auto&     shard = shard_for(key);
+    LockGuard lock{shard.lock};
+    shard.dict.insert(move(key), move(value));
+  }
+
+  // Calls func(const TValue&) under shared lock when key is found.
+  template <typename TLookup, typename TFunc>
+  bool find(const TLookup& key, TFunc&& func) {
+    auto&           shard = shard_for(key);
+    SharedLockGuard lock{shard.lock};
+    auto            it = shard.dict.find(key);
+    if (!it) {
+      return false;
+    }
+    func(static_cast<const TValue&>(it.value()));
+    return true;
+  }
+
+  // Calls func(TValue&) under exclusive lock when key is found.
+  template <typename TLookup, typename TFunc>
+  bool update(const TLookup& key, TFunc&& func) {
+    auto&     shard = shard_for(key);
+    LockGuard lock{shard.lock};
+    auto      it = shard.dict.find(key);
+    if (!it) {
+      return false;
+    }
+    func(it.value());
+    return true;
+  }
+
+  // Calls func(TValue&) under exclusive lock, value is default constructed when key is
+  // missing. Single lock and probe for counters and "find or create".
+  template <typename TFunc>
+  void upsert(TKey&& key, TFunc&& func) {
+    auto&     shard = shard_for(key);
+    LockGuard lock{shard.lock};
+    func(shard.dict.get_or_insert(move(key)));
+  }
+
+  template <typename TLookup>
+  bool contains(const TLookup& key) {
+    auto&           shard = shard_for(key);
+    SharedLockGuard lock{shard.lock};
+    return shard.dict.contains(key);
+  }
+
+  template <typename TLookup>
+  bool erase(const TLookup& key) {
+    auto&     shard = shard_for(key);
+    LockGuard lock{shard.lock};
+    return shard.dict.erase(key);
+  }
+
+  // Calls func(Dict<TKey, TValue>&) for every shard in turn under its exclusive lock.
+  // Not a snapshot: shards visited earlier may change while later ones are visited.
+  template <typename TFunc>
+  void for_each_shard(TFunc&& func) {
+    for (auto& shard : shards_) {
+      LockGuard lock{shard.lock};
+      func(shard.dict);
+    }
+  }
+
+  // Sum of shard sizes, exact only without concurrent writers.
+  size_t size() {
+    size_t result = 0;
+    for (auto& shard : shards_) {
+      SharedLockGuard lock{shard.lock};
+      result += shard.dict.size();
+    }
+    return result;
+  }
+
+  void clear() {
+    for_each_shard([](Shard& dict) { dict.clear(); });
+  }
+
+ private:
+  // Shards on separate cache lines, so locks of neighbour shards do not false share.
+  struct alignas(g_cache_line_size) LockedShard {
+    RwLock lock;
+    Shard  dict;
+  };
+
+  LockedShard shards_[shard_count];
+
+  // Shard is picked by high hash bits, Dict uses low bits for home bucket. Lookups by
+  // other types hash the same as the key they convert to, like in Dict.
+  template <typename TLookup>
+  LockedShard& shard_for(const TLookup& key) {
+    u64 hash;
+    if constexpr (LookupKey<TLookup, TKey>) {
+      hash = cc::hash<TLookup>(key);
+    } else {
+      hash = cc::hash<TKey>(key);
+    }
+    return shards_[(hash >> 32) & (shard_count - 1)];
+  }
+};
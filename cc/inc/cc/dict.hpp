@@ -1,12 +1,225 @@
 #pragma once
 #include <type_traits>
 #include "cc/common.hpp"
+#include "cc/arr-view.hpp"
 #include "cc/hash.hpp"
 
 // verstable adaptation for c++.
 // see LICENSE.verstable for more information.
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  #include <intrin.h>
+  #pragma intrinsic(_BitScanForward)
+  #pragma intrinsic(_BitScanForward64)
+  #pragma intrinsic(_BitScanReverse64)
+#endif
+
+// Metadata scans compare 8 (SSE2) or 16 (AVX2) entries at once, scalar code otherwise.
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define mVtAvx2 1
+  #define mVtSse2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define mVtSse2 1
+#endif
+
 namespace details {
+  // Metadata layout shared by type-erased (DictV, SetV) and templated (Dict) tables.
+  constexpr u16        g_vt_empty                       = 0x0000;
+  constexpr u16        g_vt_hash_frag_mask              = 0xF000;
+  constexpr u16        g_vt_in_home_bucket_mask         = 0x0800;
+  constexpr u16        g_vt_displacement_mask           = 0x07FF;
+  inline constexpr u16 g_vt_empty_placeholder_metadatum = g_vt_empty;
+  constexpr size_t     g_vt_min_nonzero_bucket_count    = 8;
+  constexpr f64        g_vt_max_load                    = 0.9;
+  // Metadata entries after the last bucket: 0x01 sentinel that stops iteration, then
+  // zeroes, so 16-wide loads starting at any bucket stay inside allocation.
+  constexpr size_t g_vt_metadata_padding = 16;
+  // Window of 16 metadata entries from home bucket holds quadratic displacements 1..5 at
+  // offsets 1, 3, 6, 10, 15. Empty slot search checks them with single compare.
+  constexpr u32 g_vt_window_size                = 16;
+  constexpr u32 g_vt_window_quadratic_mask      = 0x844A;
+  constexpr u16 g_vt_window_displacement[16]    = {0, 1, 0, 2, 0, 0, 3, 0,
+                                                   0, 0, 4, 0, 0, 0, 0, 5};
+  constexpr u16 g_vt_window_next_displacement   = 6;
+  constexpr u32 g_vt_window_next_linear_offset  = 21;
+  // Keys hashed and prefetched ahead of probing in batched lookups.
+  constexpr size_t g_vt_batch_size = 16;
+
+  inline u16 vt_hashfrag(u64 hash) {
+    return u16((hash >> 48) & g_vt_hash_frag_mask);
+  }
+
+  inline size_t vt_quadratic(u16 displacement) {
+    return ((size_t)displacement * displacement + displacement) / 2;
+  }
+
+  inline size_t vt_min_bucket_count_for_size(size_t size) {
+    if (size == 0) {
+      return 0;
+    }
+    // Round up to a power of two.
+    size_t bucket_count = g_vt_min_nonzero_bucket_count;
+    while (f64(size) > f64(bucket_count) * g_vt_max_load) {
+      bucket_count *= 2;
+    }
+    return bucket_count;
+  }
+
+  inline bool vt_is_over_max_load(size_t key_count, size_t bucket_count) {
+    return f64(key_count) > f64(bucket_count) * g_vt_max_load;
+  }
+
+#if defined(__GNUC__) && ULLONG_MAX == 0xFFFFFFFFFFFFFFFF
+  inline int vt_first_nonzero_uint16(u64 val) {
+    const u16 endian_checker = 0x0001;
+    // Little-endian (the compiler will optimize away
+    // the check at -O1 and above).
+    if (*(const char*)&endian_checker) {
+      return __builtin_ctzll(val) / 16;
+    }
+    return __builtin_clzll(val) / 16;
+  }
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  inline int vt_first_nonzero_uint16(u64 val) {
+    unsigned long result;
+
+    const u16 endian_checker = 0x0001;
+    if (*(const char*)&endian_checker) {
+      _BitScanForward64(&result, val);
+    } else {
+      _BitScanReverse64(&result, val);
+      result = 63 - result;
+    }
+
+    return int(result / 16);
+  }
+
+#else
+  inline int vt_first_nonzero_uint16(u64 val) {
+    int result = 0;
+
+    uint32_t half;
+    memcpy(&half, &val, sizeof(uint32_t));
+    if (!half) result += 2;
+
+    u16 quarter;
+    memcpy(&quarter, (char*)&val + result * sizeof(u16), sizeof(u16));
+    if (!quarter) result += 1;
+
+    return result;
+  }
+#endif
+
+  inline int vt_first_set_bit(u32 val) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long result;
+    _BitScanForward(&result, val);
+    return int(result);
+#else
+    return __builtin_ctz(val);
+#endif
+  }
+
+#if defined(mVtSse2)
+  // Bit i is set when metadata[i] is empty, for i in [0, 16).
+  inline u32 vt_empty_mask16(const u16* metadata) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo   = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)metadata), zero);
+    __m128i hi   = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)(metadata + 8)), zero);
+    return u32(_mm_movemask_epi8(_mm_packs_epi16(lo, hi)));
+  }
+#endif
+
+  inline void vt_prefetch(const void* ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#elif defined(mVtSse2)
+    _mm_prefetch((const char*)ptr, _MM_HINT_T0);
+#elif defined(_M_ARM64)
+    __prefetch(ptr);
+#endif
+  }
+
+  // Offset of the first non-empty metadatum from `metadatum`. Sentinel after the last
+  // bucket stops the scan.
+  inline size_t vt_skip_empty(const u16* metadatum) {
+    size_t offset = 0;
+#if defined(mVtAvx2)
+    __m256i zero = _mm256_setzero_si256();
+    while (true) {
+      __m256i entries = _mm256_loadu_si256((const __m256i*)(metadatum + offset));
+      u32     empty   = u32(_mm256_movemask_epi8(_mm256_cmpeq_epi16(entries, zero)));
+      if (empty != 0xFFFFFFFF) {
+        return offset + size_t(vt_first_set_bit(~empty)) / 2;
+      }
+      offset += 16;
+    }
+#elif defined(mVtSse2)
+    __m128i zero = _mm_setzero_si128();
+    while (true) {
+      __m128i entries = _mm_loadu_si128((const __m128i*)(metadatum + offset));
+      u32     empty   = u32(_mm_movemask_epi8(_mm_cmpeq_epi16(entries, zero)));
+      if (empty != 0xFFFF) {
+        return offset + size_t(vt_first_set_bit(~empty)) / 2;
+      }
+      offset += 8;
+    }
+#else
+    while (true) {
+      u64 metadata4;
+      memcpy(&metadata4, metadatum + offset, sizeof(u64));
+      if (metadata4) {
+        return offset + size_t(vt_first_nonzero_uint16(metadata4));
+      }
+      offset += 4;
+    }
+#endif
+  }
+
+  // Finds empty bucket for key with `home_bucket` and its quadratic displacement, false
+  // if displacement limit is reached.
+  inline bool vt_find_first_empty(const u16* metadata, size_t buckets_mask,
+                                  size_t home_bucket, /*out*/ size_t& empty,
+                                  /*out*/ u16& displacement) {
+    displacement               = 1;
+    size_t linear_displacement = 1;
+#if defined(mVtSse2)
+    if (home_bucket + g_vt_window_size <= buckets_mask + 1) {
+      u32 window = vt_empty_mask16(metadata + home_bucket) & g_vt_window_quadratic_mask;
+      if (window) {
+        int offset   = vt_first_set_bit(window);
+        empty        = home_bucket + size_t(offset);
+        displacement = g_vt_window_displacement[offset];
+        return true;
+      }
+      displacement        = g_vt_window_next_displacement;
+      linear_displacement = g_vt_window_next_linear_offset;
+    }
+#endif
+    while (true) {
+      empty = (home_bucket + linear_displacement) & buckets_mask;
+      if (metadata[empty] == g_vt_empty) {
+        return true;
+      }
+      if (++displacement == g_vt_displacement_mask) {
+        return false;
+      }
+      linear_displacement += displacement;
+    }
+  }
+
+  // Key comparison for lookups, same key types go through cc::equals.
+  template <typename TKey, typename TLookup>
+  bool vt_equals(const TKey& key, const TLookup& lookup) {
+    if constexpr (std::is_same_v<TKey, TLookup>) {
+      return cc::equals<TKey>(key, lookup);
+    } else {
+      return key == lookup;
+    }
+  }
+
   class DictV;
 
   struct DictVTable {
@@ -58,8 +271,11 @@ namespace details {
     void destroy();
 
     DictVItr        insert(void* key, void* value);
-    DictVItr        get(void* key);
+    DictVItr        get(void* key) const;
     bool            erase(void* key);
+    // Lookup by other key type: hash of lookup key, equals_key(bucket key, lookup key).
+    DictVItr get(u64 hash, void* key, bool (*equals_key)(void* a, void* b)) const;
+    bool     erase(u64 hash, void* key, bool (*equals_key)(void* a, void* b));
     void            erase(const DictVItr& it);
     DictVItr        begin() const;
     static DictVItr end() { return {}; }
@@ -86,8 +302,10 @@ namespace details {
 }  // namespace details
 
 
+// Type-erased dict: single DictV engine for all key/value types, hash and key comparison
+// are called through DictVTable. Smaller code than Dict, slower lookups and inserts.
 template <typename TKey, typename TValue>
-class Dict final : details::DictV {
+class VDict final : details::DictV {
  public:
   using Key   = TKey;
   using Value = TValue;
@@ -122,14 +340,26 @@ class Dict final : details::DictV {
 
     using DictVItr::operator++;
 
-    friend Dict;
+    friend VDict;
   };
 
-  Dict() {
+  VDict() {
+    // offsetof is only conditionally supported for non standard layout Bucket (Str key),
+    // compilers support it for types without virtual bases and warn.
+#if defined(__GNUC__) || defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+    constexpr size_t key_offset   = __builtin_offsetof(Bucket, key);
+    constexpr size_t value_offset = __builtin_offsetof(Bucket, value);
+#if defined(__GNUC__) || defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
     static details::DictVTable vtable{
         .bucket_size   = sizeof(Bucket),
-        .key_offset    = __builtin_offsetof(Bucket, key),
-        .value_offset  = __builtin_offsetof(Bucket, value),
+        .key_offset    = key_offset,
+        .value_offset  = value_offset,
         .hash          = v_hash,
         .equals_key    = v_equals_key,
         .move_key      = v_move_key,
@@ -143,11 +373,11 @@ class Dict final : details::DictV {
     init(&vtable);
   }
 
-  ~Dict() { destroy(); }
+  ~VDict() { destroy(); }
 
-  Dict(const Dict& other) { init(other); }
+  VDict(const VDict& other) { init(other); }
 
-  Dict& operator=(const Dict& other) {
+  VDict& operator=(const VDict& other) {
     if (this != &other) {
       destroy();
       init(other);
@@ -155,9 +385,9 @@ class Dict final : details::DictV {
     return *this;
   }
 
-  Dict(Dict&& other) noexcept : DictV() { init(static_cast<DictV&&>(other)); }
+  VDict(VDict&& other) noexcept : DictV() { init(static_cast<DictV&&>(other)); }
 
-  Dict& operator=(Dict&& other) noexcept {
+  VDict& operator=(VDict&& other) noexcept {
     if (this != &other) {
       init(static_cast<DictV&&>(other));
     }
@@ -170,6 +400,24 @@ class Dict final : details::DictV {
 
   Iterator find(const TKey& key) { return Iterator(DictV::get(&const_cast<TKey&>(key))); }
   bool     erase(const TKey& key) { return DictV::erase(&const_cast<TKey&>(key)); }
+  bool     contains(const TKey& key) const { return bool(Iterator(get_v(key))); }
+
+  template <LookupKey<TKey> TLookup>
+  Iterator find(const TLookup& key) {
+    return Iterator(get_v(key));
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool erase(const TLookup& key) {
+    return DictV::erase(cc::hash<TLookup>(key), &const_cast<TLookup&>(key),
+                        v_equals_lookup<TLookup>);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool contains(const TLookup& key) const {
+    return bool(Iterator(get_v(key)));
+  }
+
   void     erase(const Iterator& it) { return DictV::erase(it); }
   Iterator begin() const { return Iterator(DictV::begin()); }
   static constexpr Iterator end() { return Iterator(); }
@@ -205,4 +453,577 @@ class Dict final : details::DictV {
   }
   static void v_destroy_key(void* dst) { static_cast<TKey*>(dst)->~TKey(); }
   static void v_destroy_value(void* dst) { static_cast<TValue*>(dst)->~TValue(); }
+
+  template <typename TLookup>
+  static bool v_equals_lookup(void* key, void* lookup) {
+    return *static_cast<TKey*>(key) == *static_cast<TLookup*>(lookup);
+  }
+
+  details::DictVItr get_v(const TKey& key) const {
+    return DictV::get(&const_cast<TKey&>(key));
+  }
+
+  template <LookupKey<TKey> TLookup>
+  details::DictVItr get_v(const TLookup& key) const {
+    return DictV::get(cc::hash<TLookup>(key), &const_cast<TLookup&>(key),
+                      v_equals_lookup<TLookup>);
+  }
+};
+
+
+// Verstable engine instantiated per key/value types: hash and key comparison are inlined,
+// buckets are accessed as typed array. Same table layout and algorithms as DictV.
+template <typename TKey, typename TValue>
+class Dict final {
+ public:
+  using Key   = TKey;
+  using Value = TValue;
+
+  struct Bucket {
+    TKey   key;
+    TValue value;
+  };
+
+  class Iterator final {
+    Bucket* data_         = nullptr;
+    u16*    metadatum_    = nullptr;
+    u16*    metadata_end_ = nullptr;
+    size_t  home_bucket_  = 0;
+
+    friend Dict;
+
+   public:
+    Iterator() = default;
+
+    const TKey& key() const {
+      assert(!is_end());
+      return data_->key;
+    }
+
+    TValue& value() {
+      assert(!is_end());
+      return data_->value;
+    }
+
+    Bucket& operator*() const { return *data_; }
+    operator bool() const { return !is_end(); }
+
+    bool operator==(const Iterator& o) const {
+      return (is_end() && o.is_end()) || data_ == o.data_;
+    }
+    bool operator!=(const Iterator& o) const { return !(*this == o); }
+
+    Iterator& operator++() {
+      ++data_;
+      ++metadatum_;
+      fast_forward();
+      return *this;
+    }
+
+   private:
+    Iterator(Bucket* data, u16* metadatum, u16* metadata_end, size_t home_bucket)
+        : data_(data),
+          metadatum_(metadatum),
+          metadata_end_(metadata_end),
+          home_bucket_(home_bucket) {}
+
+    bool is_end() const { return metadatum_ == metadata_end_; }
+
+    void fast_forward() {
+      size_t offset = details::vt_skip_empty(metadatum_);
+      data_ += offset;
+      metadatum_ += offset;
+      home_bucket_ = SIZE_MAX;
+    }
+  };
+
+  Dict() = default;
+  ~Dict() { destroy(); }
+
+  Dict(const Dict& other) { copy_from(other); }
+
+  Dict& operator=(const Dict& other) {
+    if (this != &other) {
+      destroy();
+      copy_from(other);
+    }
+    return *this;
+  }
+
+  Dict(Dict&& other) noexcept { swap_with(other); }
+
+  Dict& operator=(Dict&& other) noexcept {
+    if (this != &other) {
+      swap_with(other);
+    }
+    return *this;
+  }
+
+  // Inserts or replaces value for key.
+  Iterator insert(TKey&& key, TValue&& value) {
+    auto [itr, inserted] = emplace_with(key, [&](Bucket* bucket) {
+      new (bucket) Bucket{move(key), move(value)};
+    });
+    if (!inserted && itr) {
+      itr.data_->key   = move(key);
+      itr.data_->value = move(value);
+    }
+    return itr;
+  }
+
+  // Constructs value from args when key is missing, existing value is kept. Second is
+  // true when value was inserted. Single probe for "find or create".
+  template <typename... TArgs>
+  Pair<Iterator, bool> try_emplace(TKey&& key, TArgs&&... args) {
+    return emplace_with(key, [&](Bucket* bucket) {
+      new (bucket) Bucket{move(key), TValue(forward<TArgs>(args)...)};
+    });
+  }
+
+  // Same, key is constructed from lookup key only when inserted.
+  template <LookupKey<TKey> TLookup, typename... TArgs>
+  Pair<Iterator, bool> try_emplace(const TLookup& key, TArgs&&... args) {
+    return emplace_with(key, [&](Bucket* bucket) {
+      new (bucket) Bucket{TKey(key), TValue(forward<TArgs>(args)...)};
+    });
+  }
+
+  // Value for key, default constructed when missing.
+  TValue& get_or_insert(TKey&& key) { return try_emplace(move(key)).first.value(); }
+
+  template <LookupKey<TKey> TLookup>
+  TValue& get_or_insert(const TLookup& key) {
+    return try_emplace(key).first.value();
+  }
+
+  // Builds dict from pairs, moving keys and values out of them. Table is sized once,
+  // later pair wins for duplicate keys.
+  static Dict build_from(ArrView<Pair<TKey, TValue>> pairs) {
+    Dict result;
+    result.reserve(pairs.size());
+    for (auto& pair : pairs) {
+      result.insert(move(pair.first), move(pair.second));
+    }
+    return result;
+  }
+
+  // Sets values[i] to value of keys[i] or nullptr when missing. Hashes a group of keys
+  // and prefetches their home buckets before probing, so memory loads of different keys
+  // overlap on large tables.
+  void find_batch(ArrView<TKey> keys, ArrView<TValue*> values) {
+    assert(keys.size() == values.size());
+    u64 hashes[details::g_vt_batch_size];
+    for (size_t begin = 0; begin < keys.size(); begin += details::g_vt_batch_size) {
+      size_t count = mMin(keys.size() - begin, details::g_vt_batch_size);
+      for (size_t i = 0; i < count; ++i) {
+        hashes[i]          = cc::hash<TKey>(keys[begin + i]);
+        size_t home_bucket = hashes[i] & buckets_mask_;
+        details::vt_prefetch(metadata_ + home_bucket);
+        details::vt_prefetch(buckets_ + home_bucket);
+      }
+      for (size_t i = 0; i < count; ++i) {
+        Iterator itr      = find_hashed(keys[begin + i], hashes[i]);
+        values[begin + i] = itr.is_end() ? nullptr : &itr.data_->value;
+      }
+    }
+  }
+
+  Iterator find(const TKey& key) { return find_impl(key); }
+
+  template <LookupKey<TKey> TLookup>
+  Iterator find(const TLookup& key) {
+    return find_impl(key);
+  }
+
+  bool contains(const TKey& key) const { return !find_impl(key).is_end(); }
+
+  template <LookupKey<TKey> TLookup>
+  bool contains(const TLookup& key) const {
+    return !find_impl(key).is_end();
+  }
+
+  bool erase(const TKey& key) { return erase_impl(key); }
+
+  template <LookupKey<TKey> TLookup>
+  bool erase(const TLookup& key) {
+    return erase_impl(key);
+  }
+
+  void erase(const Iterator& it) {
+    assert(!it.is_end());
+    erase_itr_raw(it);
+  }
+
+  Iterator begin() const {
+    if (!key_count_) {
+      return end();
+    }
+    Iterator itr(buckets_, metadata_, metadata_ + buckets_mask_ + 1, SIZE_MAX);
+    itr.fast_forward();
+    return itr;
+  }
+
+  static constexpr Iterator end() { return Iterator(); }
+
+  void clear() {
+    if (!key_count_) {
+      return;
+    }
+    for (size_t i = 0; i < bucket_count(); ++i) {
+      if (metadata_[i] != details::g_vt_empty) {
+        buckets_[i].~Bucket();
+      }
+      metadata_[i] = details::g_vt_empty;
+    }
+    key_count_ = 0;
+  }
+
+  bool reserve(size_t size) {
+    size_t a_bucket_count = details::vt_min_bucket_count_for_size(size);
+    if (a_bucket_count <= bucket_count()) {
+      return true;
+    }
+    return rehash(a_bucket_count);
+  }
+
+  bool shrink() {
+    size_t a_bucket_count = details::vt_min_bucket_count_for_size(key_count_);
+    if (a_bucket_count == bucket_count()) {
+      return true;
+    }
+    if (a_bucket_count == 0) {
+      destroy();
+      return true;
+    }
+    return rehash(a_bucket_count);
+  }
+
+  size_t size() const { return key_count_; }
+
+ private:
+  size_t  key_count_    = 0;
+  size_t  buckets_mask_ = 0;
+  Bucket* buckets_      = nullptr;
+  u16*    metadata_     = (u16*)&details::g_vt_empty_placeholder_metadatum;
+
+  size_t bucket_count() const { return buckets_mask_ + (bool)buckets_mask_; }
+
+  static size_t metadata_offset(size_t bucket_count) {
+    return ((bucket_count * sizeof(Bucket) + sizeof(u16) - 1) / sizeof(u16)) *
+           sizeof(u16);
+  }
+
+  Iterator make_itr(size_t bucket, size_t home_bucket) const {
+    return Iterator(buckets_ + bucket, metadata_ + bucket, metadata_ + buckets_mask_ + 1,
+                    home_bucket);
+  }
+
+  void destroy() {
+    if (!buckets_mask_) {
+      return;
+    }
+    clear();
+    free(buckets_);
+    key_count_    = 0;
+    buckets_mask_ = 0;
+    buckets_      = nullptr;
+    metadata_     = (u16*)&details::g_vt_empty_placeholder_metadatum;
+  }
+
+  void swap_with(Dict& other) {
+    swap(key_count_, other.key_count_);
+    swap(buckets_mask_, other.buckets_mask_);
+    swap(buckets_, other.buckets_);
+    swap(metadata_, other.metadata_);
+  }
+
+  bool allocate(size_t bucket_count) {
+    size_t offset     = metadata_offset(bucket_count);
+    void*  allocation =
+        malloc(offset + (bucket_count + details::g_vt_metadata_padding) * sizeof(u16));
+    if (!allocation) {
+      return false;
+    }
+    buckets_mask_ = bucket_count - 1;
+    buckets_      = static_cast<Bucket*>(allocation);
+    metadata_     = reinterpret_cast<u16*>(static_cast<u8*>(allocation) + offset);
+    return true;
+  }
+
+  void copy_from(const Dict& other) {
+    if (!other.buckets_mask_ || !allocate(other.bucket_count())) {
+      return;
+    }
+    key_count_ = other.key_count_;
+    memcpy(metadata_, other.metadata_,
+           (bucket_count() + details::g_vt_metadata_padding) * sizeof(u16));
+    for (size_t i = 0; i < bucket_count(); ++i) {
+      if (metadata_[i] != details::g_vt_empty) {
+        new (&buckets_[i]) Bucket(other.buckets_[i]);
+      }
+    }
+  }
+
+  bool find_first_empty(size_t home_bucket, /*out*/ size_t& empty,
+                        /*out*/ u16& displacement) const {
+    return details::vt_find_first_empty(metadata_, buckets_mask_, home_bucket, empty,
+                                        displacement);
+  }
+
+  size_t find_insert_location_in_chain(size_t home_bucket,
+                                       u16    displacement_to_empty) const {
+    size_t candidate = home_bucket;
+    while (true) {
+      u16 displacement = metadata_[candidate] & details::g_vt_displacement_mask;
+      if (displacement > displacement_to_empty) {
+        return candidate;
+      }
+      candidate = (home_bucket + details::vt_quadratic(displacement)) & buckets_mask_;
+    }
+  }
+
+  // Moves bucket contents from `src` to empty `dst`, `src` becomes empty.
+  void move_bucket(size_t dst, size_t src) {
+    new (&buckets_[dst]) Bucket(move(buckets_[src]));
+    buckets_[src].~Bucket();
+  }
+
+  void erase_itr_raw(Iterator itr) {
+    using namespace details;
+    --key_count_;
+    size_t itr_bucket = size_t(itr.metadatum_ - metadata_);
+
+    if (metadata_[itr_bucket] & g_vt_in_home_bucket_mask &&
+        (metadata_[itr_bucket] & g_vt_displacement_mask) == g_vt_displacement_mask) {
+      buckets_[itr_bucket].~Bucket();
+      metadata_[itr_bucket] = g_vt_empty;
+      return;
+    }
+
+    if (itr.home_bucket_ == SIZE_MAX) {
+      if (metadata_[itr_bucket] & g_vt_in_home_bucket_mask) {
+        itr.home_bucket_ = itr_bucket;
+      } else {
+        itr.home_bucket_ = cc::hash<TKey>(buckets_[itr_bucket].key) & buckets_mask_;
+      }
+    }
+
+    buckets_[itr_bucket].~Bucket();
+
+    if ((metadata_[itr_bucket] & g_vt_displacement_mask) == g_vt_displacement_mask) {
+      size_t bucket = itr.home_bucket_;
+      while (true) {
+        u16    displacement = metadata_[bucket] & g_vt_displacement_mask;
+        size_t next = (itr.home_bucket_ + vt_quadratic(displacement)) & buckets_mask_;
+        if (next == itr_bucket) {
+          metadata_[bucket] |= g_vt_displacement_mask;
+          metadata_[itr_bucket] = g_vt_empty;
+          return;
+        }
+        bucket = next;
+      }
+    }
+
+    size_t bucket = itr_bucket;
+    while (true) {
+      size_t prev = bucket;
+      bucket =
+          (itr.home_bucket_ + vt_quadratic(metadata_[bucket] & g_vt_displacement_mask)) &
+          buckets_mask_;
+
+      if ((metadata_[bucket] & g_vt_displacement_mask) == g_vt_displacement_mask) {
+        move_bucket(itr_bucket, bucket);
+        metadata_[itr_bucket] = u16((metadata_[itr_bucket] & ~g_vt_hash_frag_mask) |
+                                    (metadata_[bucket] & g_vt_hash_frag_mask));
+        metadata_[prev] |= g_vt_displacement_mask;
+        metadata_[bucket] = g_vt_empty;
+        return;
+      }
+    }
+  }
+
+  template <typename TLookup>
+  Iterator find_impl(const TLookup& key) const {
+    return find_hashed(key, cc::hash<TLookup>(key));
+  }
+
+  template <typename TLookup>
+  Iterator find_hashed(const TLookup& key, u64 hash) const {
+    using namespace details;
+    size_t home_bucket = hash & buckets_mask_;
+
+    if (!(metadata_[home_bucket] & g_vt_in_home_bucket_mask)) {
+      return end();
+    }
+
+    u16    hashfrag = vt_hashfrag(hash);
+    size_t bucket   = home_bucket;
+
+    while (true) {
+      if ((metadata_[bucket] & g_vt_hash_frag_mask) == hashfrag &&
+          vt_equals(buckets_[bucket].key, key)) {
+        return make_itr(bucket, home_bucket);
+      }
+
+      u16 displacement = metadata_[bucket] & g_vt_displacement_mask;
+      if (displacement == g_vt_displacement_mask) {
+        return end();
+      }
+
+      bucket = (home_bucket + vt_quadratic(displacement)) & buckets_mask_;
+    }
+  }
+
+  template <typename TLookup>
+  bool erase_impl(const TLookup& key) {
+    Iterator itr = find_impl(key);
+    if (itr.is_end()) {
+      return false;
+    }
+    erase_itr_raw(itr);
+    return true;
+  }
+
+  // Finds key or inserts bucket constructed by make(Bucket*), grows table when needed.
+  // Second is true when bucket was inserted.
+  template <typename TLookup, typename TMake>
+  Pair<Iterator, bool> emplace_with(const TLookup& key, TMake&& make) {
+    u64 hash = cc::hash<TLookup>(key);
+    while (true) {
+      bool     found = false;
+      Iterator itr   = find_or_make(key, hash, false, found, make);
+      if (!itr.is_end()) {
+        return {itr, !found};
+      }
+      if (!rehash(buckets_mask_ ? bucket_count() * 2
+                                : details::g_vt_min_nonzero_bucket_count)) {
+        return {itr, false};
+      }
+    }
+  }
+
+  // Probes chain of key's home bucket unless `unique`, on miss constructs new bucket with
+  // make(Bucket*) in free slot. Returns end when table has to grow first, make is not
+  // called then.
+  template <typename TLookup, typename TMake>
+  Iterator find_or_make(const TLookup& key, u64 hash, bool unique, /*out*/ bool& found,
+                        TMake& make) {
+    using namespace details;
+    u16    hashfrag    = vt_hashfrag(hash);
+    size_t home_bucket = hash & buckets_mask_;
+
+    if (!(metadata_[home_bucket] & g_vt_in_home_bucket_mask)) {
+      if (vt_is_over_max_load(key_count_ + 1, bucket_count()) ||
+          (metadata_[home_bucket] != g_vt_empty && !evict(home_bucket))) {
+        return end();
+      }
+
+      make(&buckets_[home_bucket]);
+      metadata_[home_bucket] =
+          hashfrag | g_vt_in_home_bucket_mask | g_vt_displacement_mask;
+      ++key_count_;
+      return make_itr(home_bucket, home_bucket);
+    }
+
+    if (!unique) {
+      size_t bucket = home_bucket;
+      while (true) {
+        if ((metadata_[bucket] & g_vt_hash_frag_mask) == hashfrag &&
+            vt_equals(buckets_[bucket].key, key)) {
+          found = true;
+          return make_itr(bucket, home_bucket);
+        }
+        u16 displacement = metadata_[bucket] & g_vt_displacement_mask;
+        if (displacement == g_vt_displacement_mask) {
+          break;
+        }
+        bucket = (home_bucket + vt_quadratic(displacement)) & buckets_mask_;
+      }
+    }
+
+    size_t empty;
+    u16    displacement;
+    if (vt_is_over_max_load(key_count_ + 1, bucket_count()) ||
+        !find_first_empty(home_bucket, empty, displacement)) {
+      return end();
+    }
+
+    size_t prev = find_insert_location_in_chain(home_bucket, displacement);
+
+    make(&buckets_[empty]);
+    metadata_[empty] = hashfrag | (metadata_[prev] & g_vt_displacement_mask);
+    metadata_[prev]  = u16((metadata_[prev] & ~g_vt_displacement_mask) | displacement);
+    ++key_count_;
+    return make_itr(empty, home_bucket);
+  }
+
+  bool evict(size_t bucket) {
+    using namespace details;
+    size_t home_bucket = cc::hash<TKey>(buckets_[bucket].key) & buckets_mask_;
+    size_t prev        = home_bucket;
+    while (true) {
+      size_t next =
+          (home_bucket + vt_quadratic(metadata_[prev] & g_vt_displacement_mask)) &
+          buckets_mask_;
+      if (next == bucket) {
+        break;
+      }
+      prev = next;
+    }
+
+    metadata_[prev] = u16((metadata_[prev] & ~g_vt_displacement_mask) |
+                          (metadata_[bucket] & g_vt_displacement_mask));
+
+    size_t empty;
+    u16    displacement;
+    if (!find_first_empty(home_bucket, empty, displacement)) {
+      return false;
+    }
+
+    prev = find_insert_location_in_chain(home_bucket, displacement);
+
+    move_bucket(empty, bucket);
+    metadata_[empty] = (metadata_[bucket] & g_vt_hash_frag_mask) |
+                       (metadata_[prev] & g_vt_displacement_mask);
+    metadata_[prev]  = u16((metadata_[prev] & ~g_vt_displacement_mask) | displacement);
+    return true;
+  }
+
+  bool rehash(size_t bucket_count) {
+    while (true) {
+      Dict new_table;
+      if (!new_table.allocate(bucket_count)) {
+        return false;
+      }
+      memset(new_table.metadata_, 0x00,
+             (bucket_count + details::g_vt_metadata_padding) * sizeof(u16));
+      new_table.metadata_[bucket_count] = 0x01;
+
+      for (size_t bucket = 0; bucket < this->bucket_count(); ++bucket) {
+        if (metadata_[bucket] != details::g_vt_empty) {
+          Bucket&  from  = buckets_[bucket];
+          auto     make  = [&](Bucket* dst) { new (dst) Bucket(move(from)); };
+          bool     found = false;
+          Iterator itr   = new_table.find_or_make(from.key, cc::hash<TKey>(from.key),
+                                                  true, found, make);
+          if (itr.is_end()) {
+            break;
+          }
+        }
+      }
+
+      if (new_table.key_count_ < key_count_) {
+        bucket_count *= 2;
+        continue;
+      }
+
+      swap_with(new_table);
+      return true;
+    }
+  }
+};
+
+template <typename TKey, typename TValue>
+struct TriviallyRelocatable<Dict<TKey, TValue>> {
+  static constexpr bool value = true;
 };
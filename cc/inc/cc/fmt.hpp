@@ -68,9 +68,9 @@ struct Fmt<ArrView<T>> {
   }
 };
 
-template <typename T>
-struct Fmt<List<T>> {
-  static void format(const List<T>& list, StrBuilder& out) {
+template <typename T, typename TAlloc>
+struct Fmt<List<T, TAlloc>> {
+  static void format(const List<T, TAlloc>& list, StrBuilder& out) {
     Fmt<StrView>::format("["_sv, out);
     size_t i = 0;
     for (const auto& value : list) {
@@ -196,9 +196,9 @@ struct StrParser<Arr<T>> {
   }
 };
 
-template <typename T>
-struct StrParser<List<T>> {
-  static bool try_parse(StrView str, List<T>& out) {
+template <typename T, typename TAlloc>
+struct StrParser<List<T, TAlloc>> {
+  static bool try_parse(StrView str, List<T, TAlloc>& out) {
     if (str.empty()) {
       return false;
     }
@@ -75,7 +75,7 @@ class Path {
   Str     read_text() const;
   Str     read_ctext() const;
 
-  const StrView& view() const { return data_; }
+  StrView        view() const { return data_; }
   u64            hash() const { return data_.hash(); }
   ComparePos     compare(StrView sv) const { return data_.compare(sv); }
   ComparePos     compare_ci(StrView sv) const { return data_.compare_ci(sv); }
@@ -96,6 +96,8 @@ class Path {
   bool operator!=(StrView other) const { return data_ != other; }
 };
 
+mTriviallyRelocatable(Path);
+
 template <>
 struct Fmt<Path> {
   static void format(const Path& v, StrBuilder& out);
@@ -108,6 +110,8 @@ inline Path operator""_p(const char* cstr, size_t size) {
 Path operator/(const Path& a, const Path& b);
 Path operator/(const Path& a, StrView b);
 Path operator/(StrView a, const Path& b);
+Path operator/(const Path& a, const Str& b);
+Path operator/(const Str& a, const Path& b);
 
 class File {
   FILE* file_ = nullptr;
@@ -1,10 +1,146 @@
 #pragma once
+#include <bit>
 #include "cc/common.hpp"
 
+#if defined(_MSC_VER) && defined(_M_X64)
+  #include <intrin.h>
+  #pragma intrinsic(_umul128)
+#endif
+
+// wyhash is inline and constexpr, so string literal hashes (_sh) are computed at compile
+// time with the same function as runtime string hashes.
+// This file contains portions of wyhash library which is licenses under The Unlicense
+// (http://unlicense.org/)
+// main repo: https://github.com/wangyi-fudan/wyhash
+
+namespace details {
+  constexpr void wy_mum(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = *a;
+    r *= *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+  #if defined(_MSC_VER) && defined(_M_X64)
+    if (!std::is_constant_evaluated()) {
+      *a = _umul128(*a, *b, b);
+      return;
+    }
+  #endif
+    u64 ha  = *a >> 32;
+    u64 hb  = *b >> 32;
+    u64 la  = (u32)*a;
+    u64 lb  = (u32)*b;
+    u64 rh  = ha * hb;
+    u64 rm0 = ha * lb;
+    u64 rm1 = hb * la;
+    u64 rl  = la * lb;
+    u64 t   = rl + (rm0 << 32);
+    u64 c   = t < rl;
+    u64 lo  = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a     = lo;
+    *b     = hi;
+#endif
+  }
+
+  constexpr u64 wy_mix(u64 a, u64 b) {
+    wy_mum(&a, &b);
+    return a ^ b;
+  }
+
+  // Little-endian reads: memcpy at runtime, byte by byte in constant evaluation.
+  template <size_t size>
+  constexpr u64 wy_read(const char* p) {
+    if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+      if constexpr (size == 8) {
+        u64 v;
+        memcpy(&v, p, 8);
+        return v;
+      } else {
+        u32 v;
+        memcpy(&v, p, 4);
+        return v;
+      }
+    }
+    u64 v = 0;
+    for (size_t i = 0; i < size; ++i) {
+      v |= u64(u8(p[i])) << (i * 8);
+    }
+    return v;
+  }
+
+  constexpr u64 wy_read3(const char* p, size_t k) {
+    return (u64(u8(p[0])) << 16) | (u64(u8(p[k >> 1])) << 8) | u8(p[k - 1]);
+  }
+}  // namespace details
+
 namespace cc {
   // --- generic data hashes
 
-  u64 hash_wy(const void* key, size_t len);
+  // wyhash, 16-48 bytes per round
+  constexpr u64 hash_wy(const char* p, size_t len) {
+    using details::wy_mix;
+    using details::wy_read;
+    u64 seed = 0xca813bf4c7abf0a9ull;
+    u64 a;
+    u64 b;
+    if (len <= 16) {
+      if (len >= 4) {
+        a = (wy_read<4>(p) << 32) | wy_read<4>(p + ((len >> 3) << 2));
+        b = (wy_read<4>(p + len - 4) << 32) | wy_read<4>(p + len - 4 - ((len >> 3) << 2));
+      } else if (len > 0) {
+        a = details::wy_read3(p, len);
+        b = 0;
+      } else {
+        a = 0;
+        b = 0;
+      }
+    } else {
+      size_t i = len;
+      if (i >= 48) {
+        u64 see1 = seed;
+        u64 see2 = seed;
+        do {
+          seed = wy_mix(wy_read<8>(p) ^ 0x8bb84b93962eacc9ull, wy_read<8>(p + 8) ^ seed);
+          see1 = wy_mix(wy_read<8>(p + 16) ^ 0x4b33a62ed433d4a3ull,
+                        wy_read<8>(p + 24) ^ see1);
+          see2 = wy_mix(wy_read<8>(p + 32) ^ 0x4d5a2da51de1aa47ull,
+                        wy_read<8>(p + 40) ^ see2);
+          p += 48;
+          i -= 48;
+        } while (i >= 48);
+        seed ^= see1 ^ see2;
+      }
+      while (i > 16) {
+        seed = wy_mix(wy_read<8>(p) ^ 0x8bb84b93962eacc9ull, wy_read<8>(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+      }
+      a = wy_read<8>(p + i - 16);
+      b = wy_read<8>(p + i - 8);
+    }
+    a ^= 0x8bb84b93962eacc9ull;
+    b ^= seed;
+    details::wy_mum(&a, &b);
+    return wy_mix(a ^ 0x2d358dccaa6c78a5ull ^ len, b ^ 0x8bb84b93962eacc9ull);
+  }
+
+  inline u64 hash_wy(const void* key, size_t len) {
+    return hash_wy(static_cast<const char*>(key), len);
+  }
+
+  // CRC-32 (zlib, gzip, png) and CRC-32C (Castagnoli: iSCSI, ext4). Update functions
+  // continue crc of previous bytes, so data can be checksummed in chunks while streaming:
+  //   u32 crc = 0;
+  //   crc     = crc32_update(crc, chunk1, size1);
+  //   crc     = crc32_update(crc, chunk2, size2);  // same as of chunk1 + chunk2 at once
+  // Large inputs use PCLMUL folding and SSE4.2 crc32 when CPU supports them.
+  u32 crc32_update(u32 crc, const void* data, size_t len);
+  u32 crc32c_update(u32 crc, const void* data, size_t len);
+
+  // CRC-32 with non zero initial value, same as crc32_update(0xca813bf4, data, len).
   u32 hash_crc32(const void* data, size_t len);
   u32 hash_fnv32(const void* data, size_t len);
 
@@ -32,4 +168,30 @@ namespace cc {
   u64 hash(const T& key) {
     return hash(u64(key));
   }
+
+  // integer hashes are inline so templated containers can fold them into probing code
+
+  template <>
+  inline u64 hash<u64>(const u64& key) {
+    u64 tmp = key;
+    tmp ^= tmp >> 23;
+    tmp *= 0x2127599bf4325c37ull;
+    tmp ^= tmp >> 47;
+    return tmp;
+  }
+
+  template <>
+  inline u64 hash<s64>(const s64& key) {
+    return hash<u64>(u64(key));
+  }
+
+  template <>
+  inline u64 hash<u32>(const u32& key) {
+    return hash<u64>(u64(key));
+  }
+
+  template <>
+  inline u64 hash<s32>(const s32& key) {
+    return hash<u64>(u64(u32(key)));
+  }
 }  // namespace cc
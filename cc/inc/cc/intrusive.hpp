@@ -0,0 +1,388 @@
+#pragma once
+#include "cc/common.hpp"
+#include "cc/hash.hpp"
+
+// Intrusive containers: link fields are members of user struct, containers never
+// allocate per element and never own elements. One object can be on several containers
+// through several link members. Linked object must not be moved or destroyed until it
+// is removed; copies of links start unlinked.
+//
+//   struct Entry {
+//     u64      id;
+//     ListLink lru_link;
+//     HashLink id_link;
+//   };
+//   IntrusiveList<Entry, &Entry::lru_link>                    lru;
+//   IntrusiveHashMap<u64, Entry, &Entry::id, &Entry::id_link> by_id;
+
+struct ListLink {
+  ListLink* next = nullptr;
+  ListLink* prev = nullptr;
+
+  ListLink() = default;
+  ListLink(const ListLink&) {}
+  ListLink& operator=(const ListLink&) { return *this; }
+  ~ListLink() { assert(!is_linked()); }
+
+  bool is_linked() const { return next != nullptr; }
+};
+
+struct HashLink {
+  HashLink* next = nullptr;
+  u64       hash = 0;
+
+  HashLink() = default;
+  HashLink(const HashLink&) {}
+  HashLink& operator=(const HashLink&) { return *this; }
+};
+
+namespace details {
+  // Offset of link in T, measured on a real object. Containers take it from every value
+  // they link, so getting object back from its link needs no object of their own.
+  template <typename T, typename TLink>
+  size_t link_offset(T& object, TLink T::*member) {
+    auto* link = reinterpret_cast<u8*>(&(object.*member));
+    return size_t(link - reinterpret_cast<u8*>(&object));
+  }
+
+  template <typename T, typename TLink>
+  T* link_owner(TLink* link, size_t offset) {
+    return reinterpret_cast<T*>(reinterpret_cast<u8*>(link) - offset);
+  }
+}  // namespace details
+
+// Circular double linked list through T::*link. All operations are O(1) except clear().
+template <typename T, ListLink T::*link>
+class IntrusiveList {
+  ListLink head_;  // sentinel: head_.next is front, head_.prev is back
+  size_t   size_        = 0;
+  size_t   link_offset_ = 0;  // set by first linked value
+
+ public:
+  class Iterator {
+    ListLink* link_   = nullptr;
+    size_t    offset_ = 0;
+
+   public:
+    Iterator(ListLink* a_link, size_t offset) : link_(a_link), offset_(offset) {}
+
+    T& operator*() const { return *details::link_owner<T>(link_, offset_); }
+    T* operator->() const { return details::link_owner<T>(link_, offset_); }
+
+    Iterator& operator++() {
+      link_ = link_->next;
+      return *this;
+    }
+    Iterator& operator--() {
+      link_ = link_->prev;
+      return *this;
+    }
+
+    bool operator==(const Iterator& o) const { return link_ == o.link_; }
+    bool operator!=(const Iterator& o) const { return link_ != o.link_; }
+  };
+
+  IntrusiveList() { head_.next = head_.prev = &head_; }
+  ~IntrusiveList() {
+    clear();
+    head_.next = head_.prev = nullptr;
+  }
+
+  IntrusiveList(const IntrusiveList&)            = delete;
+  IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+  IntrusiveList(IntrusiveList&& other) noexcept : IntrusiveList() { take(other); }
+
+  IntrusiveList& operator=(IntrusiveList&& other) noexcept {
+    if (this != &other) {
+      clear();
+      take(other);
+    }
+    return *this;
+  }
+
+  bool   empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  T& front() {
+    assert(!empty());
+    return *details::link_owner<T>(head_.next, link_offset_);
+  }
+  T& back() {
+    assert(!empty());
+    return *details::link_owner<T>(head_.prev, link_offset_);
+  }
+
+  void push_front(T& value) { insert_after(&head_, value); }
+  void push_back(T& value) { insert_after(head_.prev, value); }
+
+  T& pop_front() {
+    T& value = front();
+    remove(value);
+    return value;
+  }
+
+  T& pop_back() {
+    T& value = back();
+    remove(value);
+    return value;
+  }
+
+  // value must be on this list
+  void remove(T& value) {
+    ListLink* node = &(value.*link);
+    assert(node->is_linked());
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node->prev = nullptr;
+    --size_;
+  }
+
+  // LRU touch: value must be on this list.
+  void move_to_front(T& value) {
+    ListLink* node = &(value.*link);
+    if (head_.next == node) {
+      return;
+    }
+    remove(value);
+    insert_after(&head_, value);
+  }
+
+  // Unlinks all values.
+  void clear() {
+    ListLink* node = head_.next;
+    while (node != &head_) {
+      ListLink* next = node->next;
+      node->next = node->prev = nullptr;
+      node                    = next;
+    }
+    head_.next = head_.prev = &head_;
+    size_                   = 0;
+  }
+
+  Iterator begin() { return Iterator(head_.next, link_offset_); }
+  Iterator end() { return Iterator(&head_, link_offset_); }
+
+ private:
+  void insert_after(ListLink* position, T& value) {
+    ListLink* node = &(value.*link);
+    assert(!node->is_linked());
+    link_offset_ = details::link_offset(value, link);
+    node->prev           = position;
+    node->next           = position->next;
+    position->next->prev = node;
+    position->next       = node;
+    ++size_;
+  }
+
+  void take(IntrusiveList& other) {
+    if (other.empty()) {
+      return;
+    }
+    head_.next       = other.head_.next;
+    head_.prev       = other.head_.prev;
+    head_.next->prev = &head_;
+    head_.prev->next = &head_;
+    size_            = other.size_;
+    link_offset_     = other.link_offset_;
+    other.head_.next = other.head_.prev = &other.head_;
+    other.size_                         = 0;
+  }
+};
+
+// Chained hash map of T keyed by T::*key, chained through T::*link. Link keeps key hash,
+// so growing the bucket array does not rehash keys and chain walks compare hashes first.
+// Only the bucket array is allocated, it doubles when size exceeds bucket count.
+template <typename TKey, typename T, TKey T::*key, HashLink T::*link>
+class IntrusiveHashMap {
+  HashLink** buckets_      = nullptr;
+  size_t     buckets_mask_ = 0;
+  size_t     size_         = 0;
+  size_t     link_offset_  = 0;  // set by first linked value
+
+  static constexpr size_t min_bucket_count = 16;
+
+ public:
+  class Iterator {
+    HashLink** bucket_;
+    HashLink** buckets_end_;
+    HashLink*  link_;
+    size_t     offset_;
+
+    friend IntrusiveHashMap;
+
+    Iterator(HashLink** bucket, HashLink** buckets_end, HashLink* a_link, size_t offset)
+        : bucket_(bucket), buckets_end_(buckets_end), link_(a_link), offset_(offset) {
+      skip_empty();
+    }
+
+    void skip_empty() {
+      while (!link_ && bucket_ != buckets_end_ && ++bucket_ != buckets_end_) {
+        link_ = *bucket_;
+      }
+    }
+
+   public:
+    T& operator*() const { return *details::link_owner<T>(link_, offset_); }
+    T* operator->() const { return details::link_owner<T>(link_, offset_); }
+
+    Iterator& operator++() {
+      link_ = link_->next;
+      skip_empty();
+      return *this;
+    }
+
+    bool operator==(const Iterator& o) const { return link_ == o.link_; }
+    bool operator!=(const Iterator& o) const { return link_ != o.link_; }
+  };
+
+  IntrusiveHashMap() = default;
+  ~IntrusiveHashMap() {
+    clear();
+    ::operator delete(buckets_);
+  }
+
+  IntrusiveHashMap(const IntrusiveHashMap&)            = delete;
+  IntrusiveHashMap& operator=(const IntrusiveHashMap&) = delete;
+
+  IntrusiveHashMap(IntrusiveHashMap&& other) noexcept { swap_with(other); }
+
+  IntrusiveHashMap& operator=(IntrusiveHashMap&& other) noexcept {
+    if (this != &other) {
+      swap_with(other);
+    }
+    return *this;
+  }
+
+  bool   empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // Links value, returns false and leaves value unlinked when its key is already in map.
+  bool insert(T& value) {
+    u64 hash = cc::hash<TKey>(value.*key);
+    if (find_hashed(value.*key, hash)) {
+      return false;
+    }
+    if (size_ + 1 > bucket_count()) {
+      rehash(buckets_ ? bucket_count() * 2 : min_bucket_count);
+    }
+    HashLink*  node   = &(value.*link);
+    HashLink** bucket = &buckets_[hash & buckets_mask_];
+    node->hash        = hash;
+    node->next        = *bucket;
+    *bucket           = node;
+    link_offset_      = details::link_offset(value, link);
+    ++size_;
+    return true;
+  }
+
+  // returns null when not found
+  T* find(const TKey& lookup) const {
+    return find_hashed(lookup, cc::hash<TKey>(lookup));
+  }
+
+  template <LookupKey<TKey> TLookup>
+  T* find(const TLookup& lookup) const {
+    return find_hashed(lookup, cc::hash<TLookup>(lookup));
+  }
+
+  template <typename TLookup>
+  bool contains(const TLookup& lookup) const {
+    return find(lookup) != nullptr;
+  }
+
+  // Unlinks value with given key and returns it, null when not found.
+  template <typename TLookup>
+  T* erase(const TLookup& lookup) {
+    T* value = find(lookup);
+    if (value) {
+      remove(*value);
+    }
+    return value;
+  }
+
+  // value must be in this map
+  void remove(T& value) {
+    HashLink*  node = &(value.*link);
+    HashLink** slot = &buckets_[node->hash & buckets_mask_];
+    while (*slot != node) {
+      assert(*slot);
+      slot = &(*slot)->next;
+    }
+    *slot      = node->next;
+    node->next = nullptr;
+    --size_;
+  }
+
+  // Unlinks all values, keeps bucket array.
+  void clear() {
+    for (size_t i = 0; i < bucket_count(); ++i) {
+      buckets_[i] = nullptr;
+    }
+    size_ = 0;
+  }
+
+  Iterator begin() const {
+    if (!buckets_) {
+      return end();
+    }
+    return Iterator(buckets_, buckets_ + bucket_count(), buckets_[0], link_offset_);
+  }
+  Iterator end() const {
+    HashLink** buckets_end = buckets_ + bucket_count();
+    return Iterator(buckets_end, buckets_end, nullptr, link_offset_);
+  }
+
+ private:
+  size_t bucket_count() const { return buckets_ ? buckets_mask_ + 1 : 0; }
+
+  template <typename TLookup>
+  T* find_hashed(const TLookup& lookup, u64 hash) const {
+    if (!buckets_) {
+      return nullptr;
+    }
+    for (HashLink* node = buckets_[hash & buckets_mask_]; node; node = node->next) {
+      if (node->hash != hash) {
+        continue;
+      }
+      T* value = details::link_owner<T>(node, link_offset_);
+      if constexpr (std::is_same_v<TKey, TLookup>) {
+        if (cc::equals<TKey>(value->*key, lookup)) {
+          return value;
+        }
+      } else if (value->*key == lookup) {
+        return value;
+      }
+    }
+    return nullptr;
+  }
+
+  void rehash(size_t new_bucket_count) {
+    auto** new_buckets =
+        static_cast<HashLink**>(::operator new(new_bucket_count * sizeof(HashLink*)));
+    for (size_t i = 0; i < new_bucket_count; ++i) {
+      new_buckets[i] = nullptr;
+    }
+    size_t new_mask = new_bucket_count - 1;
+    for (size_t i = 0; i < bucket_count(); ++i) {
+      HashLink* node = buckets_[i];
+      while (node) {
+        HashLink*  next   = node->next;
+        HashLink** bucket = &new_buckets[node->hash & new_mask];
+        node->next        = *bucket;
+        *bucket           = node;
+        node              = next;
+      }
+    }
+    ::operator delete(buckets_);
+    buckets_      = new_buckets;
+    buckets_mask_ = new_mask;
+  }
+
+  void swap_with(IntrusiveHashMap& other) {
+    swap(buckets_, other.buckets_);
+    swap(buckets_mask_, other.buckets_mask_);
+    swap(size_, other.size_);
+    swap(link_offset_, other.link_offset_);
+  }
+};
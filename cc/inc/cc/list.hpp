@@ -1,18 +1,25 @@
 #pragma once
 #include "cc/common.hpp"
 #include "cc/arr.hpp"
+#include "cc/pool.hpp"
 
-// double linked list
-template <typename T>
-class List {
- public:
-  struct Node {
-    T     value;
-    Node* next = nullptr;
-    Node* prev = nullptr;
+namespace details {
+  template <typename T>
+  struct ListNode {
+    T         value;
+    ListNode* next = nullptr;
+    ListNode* prev = nullptr;
 
-    Node(T value) : value(move(value)) {}
+    ListNode(T value) : value(move(value)) {}
   };
+}  // namespace details
+
+// double linked list, nodes come from TAlloc (see pool.hpp). Default pool keeps nodes
+// of one list in contiguous chunks and reuses freed nodes, each list has its own pool.
+template <typename T, typename TAlloc = PoolAllocator<details::ListNode<T>>>
+class List {
+ public:
+  using Node = details::ListNode<T>;
 
   class Iterator {
     Node* current_ = nullptr;
@@ -74,6 +81,7 @@ class List {
   Node*  front_ = nullptr;
   Node*  back_  = nullptr;
   size_t size_  = 0;
+  TAlloc alloc_;
 
  public:
   List() = default;
@@ -87,17 +95,11 @@ class List {
     return *this;
   }
 
-  List(List&& other) {
-    swap(front_, other.front_);
-    swap(back_, other.back_);
-    swap(size_, other.size_);
-  }
+  List(List&& other) { swap_with(other); }
 
   List& operator=(List&& other) {
     if (this != &other) {
-      swap(front_, other.front_);
-      swap(back_, other.back_);
-      swap(size_, other.size_);
+      swap_with(other);
     }
     return *this;
   }
@@ -124,7 +126,7 @@ class List {
   void clear() {
     while (front_) {
       auto* next = front_->next;
-      delete front_;
+      free_node(front_);
       front_ = next;
     }
     front_ = nullptr;
@@ -146,12 +148,12 @@ class List {
     }
     --size_;
     T value(move(node->value));
-    delete node;
+    free_node(node);
     return value;
   }
 
   T& push_front(T value) {
-    auto* new_front = new Node(move(value));
+    auto* new_front = make_node(move(value));
     new_front->next = front_;
     front_          = new_front;
     if (!back_) {  // list empty
@@ -164,7 +166,7 @@ class List {
   }
 
   T& push_back(T value) {
-    auto* new_back = new Node(move(value));
+    auto* new_back = make_node(move(value));
     new_back->prev = back_;
     back_          = new_back;
     if (!front_) {  // list empty
@@ -187,7 +189,7 @@ class List {
     }
     --size_;
     T value(move(node->value));
-    delete node;
+    free_node(node);
     return value;
   }
 
@@ -202,7 +204,7 @@ class List {
     }
     --size_;
     T value(move(node->value));
-    delete node;
+    free_node(node);
     return value;
   }
 
@@ -215,12 +217,12 @@ class List {
     return res;
   }
 
+  // Splices nodes of other, allocator of this takes memory of other's allocator.
   List& append(List&& other) {
     if (empty()) {
-      swap(front_, other.front_);
-      swap(back_, other.back_);
-      swap(size_, other.size_);
+      swap_with(other);
     } else {
+      alloc_.absorb(move(other.alloc_));
       back_->next = other.front_;
       size_ += other.size_;
       if (!other.empty()) {
@@ -234,6 +236,20 @@ class List {
   }
 
  private:
+  Node* make_node(T value) { return new (alloc_.allocate()) Node(move(value)); }
+
+  void free_node(Node* node) {
+    node->~Node();
+    alloc_.deallocate(node);
+  }
+
+  void swap_with(List& other) {
+    swap(front_, other.front_);
+    swap(back_, other.back_);
+    swap(size_, other.size_);
+    swap(alloc_, other.alloc_);
+  }
+
   static void copy(const List& from, List& to) {
     assert(to.front_ == nullptr);
     for (const auto& v : from) {
@@ -1,67 +1,321 @@
 #pragma once
 #include "cc/arr.hpp"
+#include "cc/algo.hpp"
+#include "cc/error.hpp"
 #include "cc/threads.hpp"
 
 namespace details {
-  template <typename TValue>
-  class ParallelForThread final : public ThreadFunc {
-   public:
-    struct Info {
-      ArrView<TValue> values;
-      Mutex           mutex;
-      size_t          taken_jobs = 0;
-      AtomicInt       failed     = 0;
-      void (*value_func)(TValue&);
-      void (*on_error)(TValue&, const Err& err);
-    };
-
-   private:
-    Info& info_;
-
-   public:
-    explicit ParallelForThread(Info& info) : info_(info) {}
-    ~ParallelForThread() override = default;
-
-    void run() override {
-      while (true) {
-        TValue* value = nullptr;
-
-        {
-          LockGuard lg{info_.mutex};
-          if (info_.taken_jobs == info_.values.size()) {
-            return;
+  // Auto grain: claimed chunk is a share of what is left, so chunks start big and shrink
+  // towards the end of range where threads would otherwise finish unevenly.
+  constexpr size_t g_parallel_for_guided_split = 2;
+
+  // Chunks per participating thread at the end of the range when grain is not given.
+  constexpr size_t g_parallel_for_chunks_per_thread = 8;
+
+  // Size of next chunk to claim for guided scheduling, never less than min_grain.
+  inline size_t parallel_for_guided_chunk(size_t remaining, size_t threads,
+                                          size_t min_grain) {
+    return mMax(remaining / (threads * g_parallel_for_guided_split), min_grain);
+  }
+
+  // Workers claim [cursor, cursor + chunk) ranges, no locks. Fixed grain takes chunks
+  // with single fetch-add, guided computes chunk from cursor and claims it with compare
+  // exchange.
+  template <typename TFunc>
+  struct ParallelForState {
+    TFunc*    func;
+    size_t    end;
+    size_t    grain;
+    size_t    threads;
+    bool      guided;
+    AtomicInt failed = 0;
+
+    Atomic<size_t, g_cache_line_size> cursor;
+
+    bool claim(size_t& begin, size_t& chunk_end) {
+      if (!guided) {
+        begin = cursor.fetch_add(grain, MemoryOrder::Relaxed);
+        if (begin >= end) {
+          return false;
+        }
+        chunk_end = end - begin > grain ? begin + grain : end;
+        return true;
+      }
+      begin = cursor.load(MemoryOrder::Relaxed);
+      while (begin < end) {
+        size_t chunk = parallel_for_guided_chunk(end - begin, threads, grain);
+        chunk_end    = end - begin > chunk ? begin + chunk : end;
+        if (cursor.compare_exchange_weak(begin, chunk_end, MemoryOrder::Relaxed)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    static void run(void* arg) {
+      auto&  state = *(ParallelForState*)arg;
+      size_t begin = 0;
+      size_t end   = 0;
+      while (state.claim(begin, end)) {
+        for (size_t i = begin; i < end; ++i) {
+          try {
+            (*state.func)(i);
+          } catch (...) {
+            // nothing may escape: helpers still use state, workers would terminate
+            ++state.failed;
           }
-          value = &info_.values[info_.taken_jobs++];
         }
+      }
+    }
+  };
+
+  // on_error type for parallel_for over values, in non-deduced context so nullptr works
+  template <typename TData>
+  struct ParallelForOnError {
+    using Func = void (*)(TData&, const Err& err);
+  };
+
+  constexpr size_t g_parallel_sort_min_group      = 16 * 1024;
+  constexpr size_t g_parallel_reduce_min_group    = 4 * 1024;
+  constexpr size_t g_parallel_transform_min_group = 4 * 1024;
+
+  // Count of groups to split `size` values into, each group at least `min_group` values.
+  inline size_t parallel_group_count(size_t size, size_t min_group) {
+    return mClamp(size / min_group, size_t(1), Thread::hardware_thread_count());
+  }
+
+  template <typename T, typename TFunc>
+  struct ParallelSortTask {
+    ArrView<T> values;
+    TFunc*     compare_func;
+
+    static void run(ParallelSortTask& task) { sort(task.values, *task.compare_func); }
+  };
+
+  // Merges sorted left and right into out, keeps order of equal values.
+  template <typename T, typename TFunc>
+  struct ParallelMergeTask {
+    ArrView<T> left;
+    ArrView<T> right;
+    T*         out;
+    TFunc*     compare_func;
+
+    static void run(ParallelMergeTask& task) {
+      T* left      = task.left.begin();
+      T* left_end  = task.left.end();
+      T* right     = task.right.begin();
+      T* right_end = task.right.end();
+      T* out       = task.out;
+      while (left != left_end && right != right_end) {
+        if ((*task.compare_func)(*right, *left)) {
+          *out++ = move(*right++);
+        } else {
+          *out++ = move(*left++);
+        }
+      }
+      while (left != left_end) {
+        *out++ = move(*left++);
+      }
+      while (right != right_end) {
+        *out++ = move(*right++);
+      }
+    }
+  };
+
+  template <typename T, typename TResult, typename TFunc>
+  struct ParallelReduceTask {
+    ArrView<T> values;
+    TResult    result;
+    TFunc*     reduce_func;
 
+    static void run(ParallelReduceTask& task) {
+      for (const T& value : task.values) {
+        task.result = (*task.reduce_func)(move(task.result), value);
+      }
+    }
+  };
+
+  template <typename TIn, typename TOut, typename TFunc>
+  struct ParallelTransformTask {
+    ArrView<TIn> in;
+    TOut*        out;
+    TFunc*       transform_func;
+
+    static void run(ParallelTransformTask& task) {
+      for (size_t i = 0; i < task.in.size(); ++i) {
+        task.out[i] = (*task.transform_func)(task.in[i]);
+      }
+    }
+  };
+}  // namespace details
+
+// Calls func(size_t index) for every index in [begin, end) on ThreadPool::global()
+// workers, calling thread participates. Indices are claimed in chunks of `grain`. With
+// 0 chunks are guided: each claims a share of what is left, shrinking down to a grain
+// picked from range size and workers count. Returns count of indices for which func has
+// thrown, Err or any other exception.
+template <typename TFunc>
+int parallel_for(size_t begin, size_t end, TFunc&& func, size_t grain = 0) {
+  if (begin >= end) {
+    return 0;
+  }
+  ThreadPool& pool    = ThreadPool::global();
+  size_t      count   = end - begin;
+  size_t      threads = pool.workers_count() + 1;
+  bool        guided  = grain == 0;
+  if (guided) {
+    grain = mMax(count / (threads * details::g_parallel_for_chunks_per_thread),
+                 size_t(1));
+  }
+
+  using State = details::ParallelForState<RemoveRefT<TFunc>>;
+  State state;
+  state.func    = &func;
+  state.end     = end;
+  state.grain   = grain;
+  state.threads = threads;
+  state.guided  = guided;
+  state.cursor.store(begin, MemoryOrder::Relaxed);
+
+  size_t chunks  = (count + grain - 1) / grain;
+  size_t helpers = mMin(pool.workers_count(), chunks - 1);
+  Arr<ThreadPool::TaskHandle> tasks;
+  tasks.reserve(helpers);
+  for (size_t i = 0; i < helpers; ++i) {
+    tasks.push(pool.submit(State::run, &state));
+  }
+  State::run(&state);
+  for (auto& task : tasks) {
+    pool.wait(task);
+  }
+
+  return state.failed;
+}
+
+// Calls func(TData&) for every value, see parallel_for above. on_error is called for
+// values for which func has thrown Err.
+template <typename TData, typename TFunc>
+int parallel_for(ArrView<TData> data, TFunc&& func,
+                 typename details::ParallelForOnError<TData>::Func on_error = nullptr,
+                 size_t grain = 0) {
+  return parallel_for(
+      0, data.size(),
+      [&](size_t i) {
         try {
-          info_.value_func(*value);
+          func(data[i]);
         } catch (const Err& err) {
-          if (info_.on_error) {
-            info_.on_error(*value, err);
+          if (on_error) {
+            on_error(data[i], err);
           }
-          ++info_.failed;
+          throw;
         }
-      }
+      },
+      grain);
+}
+
+namespace details {
+  template <typename TTask>
+  void parallel_run(ArrView<TTask> tasks) {
+    if (parallel_for(tasks, TTask::run) != 0) {
+      throw Err("Parallel task failed"_s);
     }
-  };
+  }
 }  // namespace details
 
-template <typename TData>
-int parallel_for(const Arr<TData>& data, void (*func)(TData&),
-                 void (*on_error)(TData&, const Err& err) = nullptr) {
-  Arr<Thread> threads(Thread::hardware_thread_count() - 1);
-  typename details::ParallelForThread<TData>::Info info;
-  info.values     = data;
-  info.value_func = func;
-  info.on_error   = on_error;
+// Sorts chunks on worker threads, then merges sorted runs pairwise, also in parallel.
+// Stable only within chunks. Requires default ctor for T (merge buffer).
+template <typename T, typename TFunc>
+void parallel_sort(ArrView<T> arr, TFunc&& compare_func) {
+  using Func          = RemoveRefT<TFunc>;
+  using SortTask      = details::ParallelSortTask<T, Func>;
+  using MergeTask     = details::ParallelMergeTask<T, Func>;
+  size_t groups_count = details::parallel_group_count(arr.size(),
+                                                      details::g_parallel_sort_min_group);
+  if (groups_count <= 1) {
+    sort(arr, compare_func);
+    return;
+  }
+
+  Arr<ArrView<T>> runs = split_into_groups(arr, groups_count);
+  Arr<SortTask>   sort_tasks;
+  sort_tasks.reserve(runs.size());
+  for (auto run : runs) {
+    sort_tasks.push({run, &compare_func});
+  }
+  details::parallel_run<SortTask>(sort_tasks);
+
+  Arr<T>     buffer(arr.size());
+  ArrView<T> from = arr;
+  ArrView<T> to   = buffer;
+  while (runs.size() > 1) {
+    Arr<MergeTask>  merge_tasks;
+    Arr<ArrView<T>> merged_runs;
+    for (size_t i = 0; i < runs.size(); i += 2) {
+      ArrView<T> left  = runs[i];
+      ArrView<T> right = i + 1 < runs.size() ? runs[i + 1] : ArrView<T>();
+      T*         out   = to.data() + (left.data() - from.data());
+      merge_tasks.push({left, right, out, &compare_func});
+      merged_runs.push(ArrView<T>(out, left.size() + right.size()));
+    }
+    details::parallel_run<MergeTask>(merge_tasks);
+    runs = move(merged_runs);
+    swap(from, to);
+  }
+
+  if (from.data() != arr.data()) {
+    move(from, arr);
+  }
+}
 
-  for (auto& thread : threads) {
-    thread.start(new details::ParallelForThread<TData>{info});
+template <typename T>
+void parallel_sort(ArrView<T> arr) {
+  parallel_sort<T, details::SortFunc<T>>(arr, cc::is_less<T>);
+}
+
+// Folds values with reduce_func(TResult, const T&) -> TResult on worker threads, starting
+// each chunk from `identity`, then folds chunk results in order with
+// combine_func(TResult, TResult) -> TResult.
+template <typename T, typename TResult, typename TReduce, typename TCombine>
+TResult parallel_reduce(ArrView<T> data, TResult identity, TReduce&& reduce_func,
+                        TCombine&& combine_func) {
+  using Task          = details::ParallelReduceTask<T, TResult, RemoveRefT<TReduce>>;
+  size_t groups_count = details::parallel_group_count(
+      data.size(), details::g_parallel_reduce_min_group);
+
+  Arr<Task> tasks;
+  tasks.reserve(groups_count);
+  for (auto group : split_into_groups(data, groups_count)) {
+    tasks.push({group, identity, &reduce_func});
   }
-  for (auto& thread : threads) {
-    thread.join();
+  if (groups_count <= 1) {
+    Task::run(tasks[0]);
+  } else {
+    details::parallel_run<Task>(tasks);
   }
 
-  return info.failed;
+  TResult result = move(tasks[0].result);
+  for (size_t i = 1; i < tasks.size(); ++i) {
+    result = combine_func(move(result), move(tasks[i].result));
+  }
+  return result;
+}
+
+// Writes transform_func(in[i]) to out[i] on worker threads.
+template <typename TIn, typename TOut, typename TFunc>
+void parallel_transform(ArrView<TIn> in, ArrView<TOut> out, TFunc&& transform_func) {
+  assert(in.size() == out.size());
+  using Task          = details::ParallelTransformTask<TIn, TOut, RemoveRefT<TFunc>>;
+  size_t groups_count = details::parallel_group_count(
+      in.size(), details::g_parallel_transform_min_group);
+
+  Arr<Task> tasks;
+  tasks.reserve(groups_count);
+  for (auto group : split_into_groups(in, groups_count)) {
+    tasks.push({group, out.data() + (group.data() - in.data()), &transform_func});
+  }
+  if (groups_count <= 1) {
+    Task::run(tasks[0]);
+  } else {
+    details::parallel_run<Task>(tasks);
+  }
 }
@@ -0,0 +1,182 @@
+#pragma once
+#include "cc/common.hpp"
+
+// Allocators of single objects, used by node based containers. Allocator returns
+// uninitialized storage for one T, container constructs and destroys T in place:
+//   T*   allocate();
+//   void deallocate(T* ptr);
+//   void absorb(Allocator&& other);  // takes memory of other, objects allocated by
+//                                    // other can be deallocated through this after it
+
+// Every object is separate heap allocation.
+template <typename T>
+class HeapAllocator {
+ public:
+  T* allocate() {
+    if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      return static_cast<T*>(::operator new(sizeof(T), std::align_val_t(alignof(T))));
+    } else {
+      return static_cast<T*>(::operator new(sizeof(T)));
+    }
+  }
+
+  void deallocate(T* ptr) {
+    if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(ptr, std::align_val_t(alignof(T)));
+    } else {
+      ::operator delete(ptr);
+    }
+  }
+
+  void absorb(HeapAllocator&&) {}
+};
+
+// Slab pool: objects are carved from contiguous chunks, freed objects go to free list and
+// are reused first. Chunks grow from `min_chunk_count` to `max_chunk_count` objects and
+// are released only when pool is destroyed, so churn does not touch the heap and
+// objects allocated one after another stay adjacent in memory. Not thread safe.
+template <typename T, size_t min_chunk_count = 16, size_t max_chunk_count = 1024>
+class PoolAllocator {
+  static_assert(min_chunk_count > 0 && min_chunk_count <= max_chunk_count);
+
+  union Slot {
+    Slot* next;
+    alignas(T) u8 storage[sizeof(T)];
+  };
+
+  struct alignas(Slot) Chunk {
+    Chunk* prev;
+    size_t count;
+
+    Slot* slots() { return reinterpret_cast<Slot*>(this + 1); }
+  };
+
+  Chunk* chunks_     = nullptr;  // newest first
+  Chunk* last_chunk_ = nullptr;  // oldest, chunks of absorbed pool are linked after it
+  Slot*  free_       = nullptr;
+  Slot*  bump_       = nullptr;  // not yet used part of newest chunk
+  Slot*  bump_end_   = nullptr;
+  size_t next_count_ = min_chunk_count;
+
+ public:
+  PoolAllocator() = default;
+  ~PoolAllocator() { release(); }
+
+  PoolAllocator(const PoolAllocator&)            = delete;
+  PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+  PoolAllocator(PoolAllocator&& other) noexcept { swap_with(other); }
+
+  PoolAllocator& operator=(PoolAllocator&& other) noexcept {
+    if (this != &other) {
+      release();
+      swap_with(other);
+    }
+    return *this;
+  }
+
+  T* allocate() {
+    if (free_) {
+      Slot* slot = free_;
+      free_      = slot->next;
+      return reinterpret_cast<T*>(slot->storage);
+    }
+    if (bump_ == bump_end_) {
+      add_chunk();
+    }
+    return reinterpret_cast<T*>((bump_++)->storage);
+  }
+
+  void deallocate(T* ptr) {
+    Slot* slot = reinterpret_cast<Slot*>(ptr);
+    slot->next = free_;
+    free_      = slot;
+  }
+
+  // Chunks of other are appended to ours. Its free list is spliced to ours, which walks
+  // that list; unused tail of its newest chunk is dropped until pool is destroyed.
+  void absorb(PoolAllocator&& other) {
+    if (!other.chunks_) {
+      return;
+    }
+    if (other.free_) {
+      Slot* tail = other.free_;
+      while (tail->next) {
+        tail = tail->next;
+      }
+      tail->next = free_;
+      free_      = other.free_;
+    }
+    if (chunks_) {
+      last_chunk_->prev = other.chunks_;
+      last_chunk_       = other.last_chunk_;
+    } else {
+      chunks_     = other.chunks_;
+      last_chunk_ = other.last_chunk_;
+      bump_       = other.bump_;
+      bump_end_   = other.bump_end_;
+      next_count_ = other.next_count_;
+    }
+    other.chunks_     = nullptr;
+    other.last_chunk_ = nullptr;
+    other.free_       = nullptr;
+    other.bump_       = nullptr;
+    other.bump_end_   = nullptr;
+    other.next_count_ = min_chunk_count;
+  }
+
+  // Total count of objects in all chunks, used or not.
+  size_t capacity() const {
+    size_t result = 0;
+    for (Chunk* chunk = chunks_; chunk; chunk = chunk->prev) {
+      result += chunk->count;
+    }
+    return result;
+  }
+
+ private:
+  void add_chunk() {
+    size_t count = next_count_;
+    size_t size  = sizeof(Chunk) + count * sizeof(Slot);
+    void*  memory;
+    if constexpr (alignof(Slot) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      memory = ::operator new(size, std::align_val_t(alignof(Slot)));
+    } else {
+      memory = ::operator new(size);
+    }
+    Chunk* chunk = new (memory) Chunk{chunks_, count};
+    if (!last_chunk_) {
+      last_chunk_ = chunk;
+    }
+    chunks_     = chunk;
+    bump_       = chunk->slots();
+    bump_end_   = bump_ + count;
+    next_count_ = mMin(count * 2, max_chunk_count);
+  }
+
+  void release() {
+    while (chunks_) {
+      Chunk* prev = chunks_->prev;
+      if constexpr (alignof(Slot) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        ::operator delete(chunks_, std::align_val_t(alignof(Slot)));
+      } else {
+        ::operator delete(chunks_);
+      }
+      chunks_ = prev;
+    }
+    last_chunk_ = nullptr;
+    free_       = nullptr;
+    bump_       = nullptr;
+    bump_end_   = nullptr;
+    next_count_ = min_chunk_count;
+  }
+
+  void swap_with(PoolAllocator& other) {
+    swap(chunks_, other.chunks_);
+    swap(last_chunk_, other.last_chunk_);
+    swap(free_, other.free_);
+    swap(bump_, other.bump_);
+    swap(bump_end_, other.bump_end_);
+    swap(next_count_, other.next_count_);
+  }
+};
@@ -1,48 +1,114 @@
 #pragma once
 #include "cc/common.hpp"
 #include "cc/arr.hpp"
+#include "cc/algo.hpp"
 
+// Flat map over two parallel arrays, sorted by key. Lookups are branchless binary search
+// over the key array, values stay in separate array so search touches only keys.
 template <typename TKey, typename TValue>
 class SDict {
-  Arr<TKey>   keys_;
+  Arr<TKey>   keys_;  // sizes of both arrays are size of dict
   Arr<TValue> values_;
-  size_t      size_ = 0;
 
  public:
   using Key   = TKey;
   using Value = TValue;
 
-  void reserve(size_t size) {
-    keys_.resize(size);
-    values_.resize(size);
+  // Allocates space for `capacity` entries, constructs nothing.
+  void reserve(size_t capacity) {
+    keys_.reserve(capacity);
+    values_.reserve(capacity);
   }
-  void resize(size_t size) { reserve(size); }
 
   // expects key to be unique, does no checks for it
   void insert(TKey key, TValue value) {
-    assert(size_ < keys_.size());
-    keys_[size_]   = move(key);
-    values_[size_] = move(value);
-    size_++;
+    keys_.push(move(key));
+    values_.push(move(value));
   }
 
-  size_t size() const { return size_; }
+  size_t size() const { return keys_.size(); }
 
+  // Sorts entries by key: entries are moved out into array of pairs, pdq sorted there
+  // and moved back, so sort works on contiguous entries instead of two arrays.
   void sort() {
-    if (size_ <= 1) {
+    if (is_sorted()) {
       return;
     }
-    for (size_t i = 0; i < size_; ++i) {
-      bool swapped = false;
-      for (size_t j = 0; j < size_ - i - 1; ++j) {
-        if (cc::is_less<TKey>(keys_[j + 1], keys_[j])) {
-          swapped = true;
-          swap(keys_[j], keys_[j + 1]);
-          swap(values_[j], values_[j + 1]);
-        }
+    using Entry = Pair<TKey, TValue>;
+    Arr<Entry> entries;
+    entries.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+      entries.push(Entry{move(keys_[i]), move(values_[i])});
+    }
+    ::sort(ArrView<Entry>(entries), [](const Entry& a, const Entry& b) {
+      return cc::is_less<TKey>(a.first, b.first);
+    });
+    for (size_t i = 0; i < size(); ++i) {
+      keys_[i]   = move(entries[i].first);
+      values_[i] = move(entries[i].second);
+    }
+  }
+
+  bool is_sorted() const {
+    for (size_t i = 1; i < size(); ++i) {
+      if (cc::is_less<TKey>(keys_[i], keys_[i - 1])) {
+        return false;
       }
-      if (!swapped) {  // array is sorted
-        return;
+    }
+    return true;
+  }
+
+  // Merges sorted unique keys with their values into sorted dict, O(size + keys.size()).
+  // Keys must not be in dict yet. Nothing is re-sorted and no slot is default
+  // constructed: entries which end up past the old end are appended in order, the rest
+  // is merged from the back into old slots. Moves from keys and values.
+  void insert_sorted(ArrView<TKey> keys, ArrView<TValue> values) {
+    assert(keys.size() == values.size());
+    assert(is_sorted_unique(keys) && "keys must be sorted and unique");
+    assert(!contains_any(keys) && "keys must not be in dict");
+    size_t old_size = size();
+    size_t count    = keys.size();
+    reserve(old_size + count);
+
+    // Walk the merge backwards without moving, to count old entries among the largest
+    // `count` ones. Equal compare keeps new key after old, as in the merges below.
+    size_t left  = old_size;
+    size_t right = count;
+    for (size_t i = 0; i < count; ++i) {
+      if (left > 0 && cc::is_less<TKey>(keys[right - 1], keys_[left - 1])) {
+        --left;
+      } else {
+        --right;
+      }
+    }
+
+    // largest entries: old [left, old_size) and new [right, count), appended in order
+    size_t split = right;
+    for (size_t old_i = left, new_i = right; old_i < old_size || new_i < count;) {
+      if (new_i == count ||
+          (old_i < old_size && !cc::is_less<TKey>(keys[new_i], keys_[old_i]))) {
+        keys_.push(move(keys_[old_i]));
+        values_.push(move(values_[old_i]));
+        ++old_i;
+      } else {
+        keys_.push(move(keys[new_i]));
+        values_.push(move(values[new_i]));
+        ++new_i;
+      }
+    }
+
+    // rest: old [0, left) and new [0, split), merged from the back into [0, old_size)
+    size_t out = old_size;
+    while (split > 0) {
+      --out;
+      if (left > 0 && cc::is_less<TKey>(keys[split - 1], keys_[left - 1])) {
+        --left;
+        keys_[out]   = move(keys_[left]);
+        values_[out] = move(values_[left]);
+      } else {
+        --split;
+        keys_[out]   = move(keys[split]);
+        values_[out] = move(values[split]);
       }
     }
   }
@@ -53,49 +119,75 @@ class SDict {
     return *value;
   }
 
+  // Index of first key not less than `key`, size() when there is none. Fixed number of
+  // steps for given size, the compare picks next base without branching, so there are
+  // no mispredicts and next middles can be prefetched.
+  size_t lower_bound(const TKey& key) const {
+    if (size() == 0) {
+      return 0;
+    }
+    const TKey* base  = keys_.data();
+    size_t      count = size();
+    while (count > 1) {
+      size_t half = count / 2;
+#if defined(__GNUC__) || defined(__clang__)
+      // both candidates for next middle, loads overlap with the compare
+      __builtin_prefetch(base + half / 2);
+      __builtin_prefetch(base + half + half / 2);
+#endif
+      base        = cc::is_less<TKey>(base[half], key) ? base + half : base;
+      count      -= half;
+    }
+    return size_t(base - keys_.data()) + size_t(cc::is_less<TKey>(*base, key));
+  }
+
+  // Index of first key greater than `key`, size() when there is none.
+  size_t upper_bound(const TKey& key) const {
+    size_t index = lower_bound(key);
+    return index < size() && !cc::is_less<TKey>(key, keys_[index]) ? index + 1 : index;
+  }
+
   // returns null when not found
-  // TODO: fix s32 indexing
   TValue* find(const TKey& key) {
-    if (size_ == 0) {
-      return nullptr;
-    }
-    if (size_ == 1) {
-      return keys_[0] == key ? &values_[0] : nullptr;
-    }
-    s32 low  = 0;
-    s32 high = s32(size_) - 1;
-    while (low <= high) {
-      s32 mid = low + (high - low) / 2;
-      if (keys_[size_t(mid)] == key) {
-        return &values_[size_t(mid)];
-      }
-      if (keys_[size_t(mid)] < key) {
-        low = mid + 1;
-      } else {
-        high = mid - 1;
-      }
+    size_t index = lower_bound(key);
+    if (index < size() && !cc::is_less<TKey>(key, keys_[index])) {
+      return &values_[index];
     }
     return nullptr;
   }
 
-  template <typename T>
-  TValue* find_non_sorted(const T& key) {
-    for (size_t i = 0; i < size_; i++) {
-      if (keys_[i] == key) {
-        return &values_[i];
-      }
-    }
-    return nullptr;
+  const TValue* find(const TKey& key) const { return const_cast<SDict*>(this)->find(key); }
+
+  struct Range {
+    ArrView<TKey>   keys;
+    ArrView<TValue> values;
+
+    size_t size() const { return keys.size(); }
+  };
+
+  // Entries with from <= key < to.
+  Range range(const TKey& from, const TKey& to) {
+    size_t begin = lower_bound(from);
+    size_t end   = mMax(begin, lower_bound(to));
+    return {keys().sub(begin, end - begin), values().sub(begin, end - begin)};
   }
 
-  template <typename T>
-  const TValue* find_non_sorted(const T& key) const {
-    for (size_t i = 0; i < size_; i++) {
-      if (keys_[i] == key) {
-        return &values_[i];
-      }
-    }
-    return nullptr;
+  ArrView<TKey>   keys() { return keys_; }
+  ArrView<TValue> values() { return values_; }
+
+  TValue* find_non_sorted(const TKey& key) { return find_non_sorted_impl(key); }
+  const TValue* find_non_sorted(const TKey& key) const {
+    return const_cast<SDict*>(this)->find_non_sorted_impl(key);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  TValue* find_non_sorted(const TLookup& key) {
+    return find_non_sorted_impl(key);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  const TValue* find_non_sorted(const TLookup& key) const {
+    return const_cast<SDict*>(this)->find_non_sorted_impl(key);
   }
 
   struct IterView {
@@ -117,7 +209,7 @@ class SDict {
       return IterView(dict_->keys_[index_], dict_->values_[index_]);
     }
     Iter& operator++() {
-      if (++index_ == dict_->size_) {
+      if (++index_ == dict_->size()) {
         index_ = 0;
         dict_  = nullptr;
       }
@@ -125,6 +217,35 @@ class SDict {
     }
   };
 
-  Iter        begin() { return size_ > 0 ? Iter(this, 0) : end(); }
+  Iter        begin() { return size() > 0 ? Iter(this, 0) : end(); }
   static Iter end() { return Iter(nullptr, 0); }
+
+ private:
+  template <typename TLookup>
+  TValue* find_non_sorted_impl(const TLookup& key) {
+    for (size_t i = 0; i < size(); i++) {
+      if (keys_[i] == key) {
+        return &values_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  static bool is_sorted_unique(ArrView<TKey> keys) {
+    for (size_t i = 1; i < keys.size(); ++i) {
+      if (!cc::is_less<TKey>(keys[i - 1], keys[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool contains_any(ArrView<TKey> keys) const {
+    for (const TKey& key : keys) {
+      if (find(key)) {
+        return true;
+      }
+    }
+    return false;
+  }
 };
@@ -52,8 +52,11 @@ namespace details {
     void destroy();
 
     SetVItr        insert(void* key);
-    SetVItr        get(void* key);
+    SetVItr        get(void* key) const;
     bool           erase(void* key);
+    // Lookup by other key type: hash of lookup key, equals_key(bucket key, lookup key).
+    SetVItr get(u64 hash, void* key, bool (*equals_key)(void* a, void* b)) const;
+    bool    erase(u64 hash, void* key, bool (*equals_key)(void* a, void* b));
     SetVItr        begin() const;
     static SetVItr end() { return {}; }
     size_t         size() const;
@@ -137,8 +140,50 @@ class Set final : details::SetV {
   }
 
   Iterator insert(TKey&& key) { return Iterator(SetV::insert(&key)); }
-  Iterator find(const TKey& key) { return Iterator(SetV::get(&const_cast<TKey&>(key))); }
+  Iterator find(const TKey& key) { return Iterator(get_v(key)); }
   bool     erase(const TKey& key) { return SetV::erase(&const_cast<TKey&>(key)); }
+  bool     contains(const TKey& key) const { return bool(Iterator(get_v(key))); }
+
+  template <LookupKey<TKey> TLookup>
+  Iterator find(const TLookup& key) {
+    return Iterator(get_v(key));
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool erase(const TLookup& key) {
+    return SetV::erase(cc::hash<TLookup>(key), &const_cast<TLookup&>(key),
+                       v_equals_lookup<TLookup>);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool contains(const TLookup& key) const {
+    return bool(Iterator(get_v(key)));
+  }
+
+  // Inserts copies of all keys of other.
+  void merge(const Set& other) {
+    reserve(size() + other.size());
+    for (const TKey& key : other) {
+      insert(TKey(key));
+    }
+  }
+
+  // Takes keys of other, leaves it empty. Larger table is kept: when other is larger,
+  // tables are swapped first and only keys of the smaller one are moved over.
+  void merge(Set&& other) {
+    if (this == &other) {
+      return;
+    }
+    if (size() < other.size()) {
+      init(static_cast<SetV&&>(other));
+    }
+    reserve(size() + other.size());
+    for (const TKey& key : other) {
+      insert(move(const_cast<TKey&>(key)));
+    }
+    other.clear();
+  }
+
   Iterator begin() const { return Iterator(SetV::begin()); }
   static constexpr Iterator end() { return Iterator(); }
 
@@ -159,4 +204,79 @@ class Set final : details::SetV {
     new (dst) TKey(*static_cast<const TKey*>(src));
   }
   static void v_destroy_key(void* dst) { static_cast<TKey*>(dst)->~TKey(); }
+
+  template <typename TLookup>
+  static bool v_equals_lookup(void* key, void* lookup) {
+    return *static_cast<TKey*>(key) == *static_cast<TLookup*>(lookup);
+  }
+
+  details::SetVItr get_v(const TKey& key) const {
+    return SetV::get(&const_cast<TKey&>(key));
+  }
+
+  template <LookupKey<TKey> TLookup>
+  details::SetVItr get_v(const TLookup& key) const {
+    return SetV::get(cc::hash<TLookup>(key), &const_cast<TLookup&>(key),
+                     v_equals_lookup<TLookup>);
+  }
 };
+
+// Set algebra. Each operation iterates the smaller operand where result allows it and
+// reserves result up front, so there is a single allocation and no rehash.
+
+template <typename TKey>
+Set<TKey> set_union(const Set<TKey>& a, const Set<TKey>& b) {
+  const Set<TKey>& larger  = a.size() >= b.size() ? a : b;
+  const Set<TKey>& smaller = a.size() >= b.size() ? b : a;
+  Set<TKey>        result(larger);
+  result.merge(smaller);
+  return result;
+}
+
+template <typename TKey>
+Set<TKey> set_intersect(const Set<TKey>& a, const Set<TKey>& b) {
+  const Set<TKey>& larger  = a.size() >= b.size() ? a : b;
+  const Set<TKey>& smaller = a.size() >= b.size() ? b : a;
+  Set<TKey>        result;
+  result.reserve(smaller.size());
+  for (const TKey& key : smaller) {
+    if (larger.contains(key)) {
+      result.insert(TKey(key));
+    }
+  }
+  return result;
+}
+
+// Keys of a which are not in b. When b is smaller, a is copied and keys of b are erased.
+template <typename TKey>
+Set<TKey> set_difference(const Set<TKey>& a, const Set<TKey>& b) {
+  if (b.size() < a.size()) {
+    Set<TKey> result(a);
+    for (const TKey& key : b) {
+      result.erase(key);
+    }
+    return result;
+  }
+  Set<TKey> result;
+  result.reserve(a.size());
+  for (const TKey& key : a) {
+    if (!b.contains(key)) {
+      result.insert(TKey(key));
+    }
+  }
+  return result;
+}
+
+// True when every key of a is in b.
+template <typename TKey>
+bool is_subset(const Set<TKey>& a, const Set<TKey>& b) {
+  if (a.size() > b.size()) {
+    return false;
+  }
+  for (const TKey& key : a) {
+    if (!b.contains(key)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include "cc/common.hpp"
+#include "cc/set.hpp"
+
+// Set which keeps up to N keys inline and finds them by linear scan, so small sets do not
+// allocate. Inserting key N + 1 moves all keys into Set, which is used from then on,
+// until clear() returns set to inline mode.
+template <typename TKey, size_t N = 16>
+class SmallSet final {
+  static_assert(N > 0, "inline capacity must be non zero");
+
+  alignas(TKey) u8 storage_[sizeof(TKey) * N];
+
+  size_t    inline_size_ = 0;
+  bool      promoted_    = false;
+  Set<TKey> set_;
+
+ public:
+  using Key = TKey;
+
+  class Iterator final {
+    const TKey*                  key_ = nullptr;
+    const TKey*                  end_ = nullptr;
+    typename Set<TKey>::Iterator set_itr_;
+
+    friend SmallSet;
+
+   public:
+    Iterator() = default;
+
+    const TKey& key() const { return key_ ? *key_ : set_itr_.key(); }
+    const TKey& operator*() const { return key(); }
+    operator bool() const { return key_ ? key_ != end_ : bool(set_itr_); }
+
+    bool operator==(const Iterator& o) const {
+      if (!*this || !o) {
+        return !*this && !o;
+      }
+      return &key() == &o.key();
+    }
+    bool operator!=(const Iterator& o) const { return !(*this == o); }
+
+    Iterator& operator++() {
+      if (key_) {
+        ++key_;
+      } else {
+        ++set_itr_;
+      }
+      return *this;
+    }
+  };
+
+  SmallSet() = default;
+  ~SmallSet() { destroy_inline(); }
+
+  SmallSet(const SmallSet& other) { copy_from(other); }
+
+  SmallSet& operator=(const SmallSet& other) {
+    if (this != &other) {
+      clear();
+      copy_from(other);
+    }
+    return *this;
+  }
+
+  SmallSet(SmallSet&& other) noexcept { move_from(move(other)); }
+
+  SmallSet& operator=(SmallSet&& other) noexcept {
+    if (this != &other) {
+      clear();
+      move_from(move(other));
+    }
+    return *this;
+  }
+
+  // Returns false when key is already in set.
+  bool insert(TKey&& key) {
+    if (promoted_) {
+      size_t size_before = set_.size();
+      set_.insert(move(key));
+      return set_.size() != size_before;
+    }
+    if (find_inline(key) != inline_size_) {
+      return false;
+    }
+    if (inline_size_ == N) {
+      promote();
+      set_.insert(move(key));
+      return true;
+    }
+    new (inline_keys() + inline_size_) TKey(move(key));
+    ++inline_size_;
+    return true;
+  }
+
+  Iterator find(const TKey& key) const { return find_impl(key); }
+  bool     contains(const TKey& key) const { return contains_impl(key); }
+
+  // Inline keys are kept dense: erased key is replaced by the last one.
+  bool erase(const TKey& key) { return erase_impl(key); }
+
+  template <LookupKey<TKey> TLookup>
+  Iterator find(const TLookup& key) const {
+    return find_impl(key);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool contains(const TLookup& key) const {
+    return contains_impl(key);
+  }
+
+  template <LookupKey<TKey> TLookup>
+  bool erase(const TLookup& key) {
+    return erase_impl(key);
+  }
+
+  void clear() {
+    destroy_inline();
+    set_      = Set<TKey>();
+    promoted_ = false;
+  }
+
+  Iterator begin() const {
+    Iterator itr;
+    if (promoted_) {
+      itr.set_itr_ = set_.begin();
+    } else if (inline_size_ > 0) {
+      itr.key_ = inline_keys();
+      itr.end_ = inline_keys() + inline_size_;
+    }
+    return itr;
+  }
+  static Iterator end() { return Iterator(); }
+
+  size_t size() const { return promoted_ ? set_.size() : inline_size_; }
+  bool   empty() const { return size() == 0; }
+  bool   is_inline() const { return !promoted_; }
+
+ private:
+  TKey*       inline_keys() { return reinterpret_cast<TKey*>(storage_); }
+  const TKey* inline_keys() const { return reinterpret_cast<const TKey*>(storage_); }
+
+  template <typename TLookup>
+  Iterator find_impl(const TLookup& key) const {
+    Iterator itr;
+    if (promoted_) {
+      itr.set_itr_ = const_cast<Set<TKey>&>(set_).find(key);
+      return itr;
+    }
+    size_t index = find_inline(key);
+    if (index != inline_size_) {
+      itr.key_ = inline_keys() + index;
+      itr.end_ = inline_keys() + inline_size_;
+    }
+    return itr;
+  }
+
+  template <typename TLookup>
+  bool contains_impl(const TLookup& key) const {
+    return promoted_ ? set_.contains(key) : find_inline(key) != inline_size_;
+  }
+
+  template <typename TLookup>
+  bool erase_impl(const TLookup& key) {
+    if (promoted_) {
+      return set_.erase(key);
+    }
+    size_t index = find_inline(key);
+    if (index == inline_size_) {
+      return false;
+    }
+    TKey* keys = inline_keys();
+    if (index != inline_size_ - 1) {
+      keys[index] = move(keys[inline_size_ - 1]);
+    }
+    keys[--inline_size_].~TKey();
+    return true;
+  }
+
+  // TLookup is TKey or LookupKey<TKey>
+  template <typename TLookup>
+  size_t find_inline(const TLookup& key) const {
+    const TKey* keys = inline_keys();
+    for (size_t i = 0; i < inline_size_; ++i) {
+      if constexpr (std::is_same_v<TKey, TLookup>) {
+        if (cc::equals<TKey>(keys[i], key)) {
+          return i;
+        }
+      } else if (keys[i] == key) {
+        return i;
+      }
+    }
+    return inline_size_;
+  }
+
+  void promote() {
+    set_.reserve(N * 2);
+    TKey* keys = inline_keys();
+    for (size_t i = 0; i < inline_size_; ++i) {
+      set_.insert(move(keys[i]));
+    }
+    destroy_inline();
+    promoted_ = true;
+  }
+
+  void destroy_inline() {
+    TKey* keys = inline_keys();
+    for (size_t i = 0; i < inline_size_; ++i) {
+      keys[i].~TKey();
+    }
+    inline_size_ = 0;
+  }
+
+  void copy_from(const SmallSet& other) {
+    promoted_ = other.promoted_;
+    set_      = other.set_;
+    for (size_t i = 0; i < other.inline_size_; ++i) {
+      new (inline_keys() + i) TKey(other.inline_keys()[i]);
+    }
+    inline_size_ = other.inline_size_;
+  }
+
+  void move_from(SmallSet&& other) {
+    promoted_ = other.promoted_;
+    set_      = move(other.set_);
+    for (size_t i = 0; i < other.inline_size_; ++i) {
+      new (inline_keys() + i) TKey(move(other.inline_keys()[i]));
+    }
+    inline_size_ = other.inline_size_;
+    other.clear();
+  }
+};
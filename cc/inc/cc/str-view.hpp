@@ -15,7 +15,13 @@ class StrView {
 
   StrView() = default;
   StrView(const char* str);
-  StrView(const char* str, size_t size);
+  StrView(const char* str, size_t size) {
+    if (size) {
+      assert(str != nullptr);
+      data_ = const_cast<char*>(str);
+      size_ = size;
+    }
+  }
 
   bool        empty() const { return size_ == 0; }
   size_t      size() const { return size_; }
@@ -28,7 +34,10 @@ class StrView {
   char&       operator[](size_t index) { return data_[index]; }
   const char& operator[](size_t index) const { return data_[index]; }
 
-  bool operator==(StrView sv) const;
+  // compares bytes, strings may have embedded zeros
+  bool operator==(StrView sv) const {
+    return size_ == sv.size_ && (size_ == 0 || memcmp(data_, sv.data_, size_) == 0);
+  }
   bool operator!=(StrView sv) const { return !this->operator==(sv); }
 
   void assign(StrView other);
@@ -39,11 +48,12 @@ class StrView {
   bool             ends_with(StrView sv) const;
   ComparePos       compare(StrView sv) const;
   ComparePos       compare_ci(StrView sv) const;  // case-insensitive
-  u64              hash() const;
+  u64              hash() const { return cc::hash_wy(data_, size_); }
   size_t           find(char c) const;
   size_t           find_last(char c) const;
   size_t           find(StrView term) const;
   size_t           find_last(StrView term) const;
+  size_t           find_any_of(StrView chars) const;  // first of any of chars
   StrView          sub(size_t from, size_t count = UINT64_MAX) const;
   ArrView<StrView> split(char by, ArrView<StrView> out) const;
   ArrView<StrView> split_se(char by, ArrView<StrView> out) const;  // skip-empty
@@ -91,7 +101,7 @@ class StrHash {
   StrHash(StrView str);
   explicit constexpr StrHash(u64 hash) : hash_(hash) {}
 
-  u64 hash() const { return hash_; }
+  constexpr u64 hash() const { return hash_; }
 
   bool operator==(const StrHash& o) const { return hash_ == o.hash_; }
   bool operator!=(const StrHash& o) const { return hash_ != o.hash_; }
@@ -99,5 +109,5 @@ class StrHash {
 };
 
 inline constexpr StrHash operator""_sh(const char* cstr, size_t size) {
-  return StrHash(cc::hash_fnv64(cstr, size));
+  return StrHash(cc::hash_wy(cstr, size));
 }
@@ -5,6 +5,8 @@
 
 class Str;
 
+// Text buffer, first 128 bytes are in small buffer, then heap buffer grows
+// geometrically. to_string() hands heap buffer to Str without copying.
 class StrBuilder {
   char*  data_;
   size_t size_;
@@ -15,9 +17,8 @@ class StrBuilder {
   StrBuilder();
   ~StrBuilder() noexcept;
 
-  // no movable
-  StrBuilder(StrBuilder&& other)            = delete;
-  StrBuilder& operator=(StrBuilder&& other) = delete;
+  StrBuilder(StrBuilder&& other) noexcept;
+  StrBuilder& operator=(StrBuilder&& other) noexcept;
 
   // no copyable
   StrBuilder(const StrBuilder&)            = delete;
@@ -34,16 +35,44 @@ class StrBuilder {
 
  private:
   void init();
+  void take(StrBuilder& other);
 };
 
 
-class Str : public StrView {
+// Owning string, 24 bytes. Strings up to `inline_capacity` bytes are stored inside Str
+// itself with size in the last byte, longer ones in heap buffer which grows geometrically
+// on append. Top bit of the last byte tags inline storage, it is the top bit of heap
+// capacity otherwise (little endian). Empty Str has no storage and null data().
+// Str holds no pointers into itself, so it is trivially relocatable.
+class Str {
+ public:
+  using ValueType = char;
+
+  inline static constexpr size_t npos            = StrView::npos;
+  static constexpr size_t        inline_capacity = 23;
+
+ private:
+  struct Heap {
+    char*  data;
+    size_t size;
+    size_t capacity;
+  };
+
+  static constexpr u8 inline_tag = 0x80;
+
+  union {
+    Heap heap_ = {};
+    char inline_[sizeof(Heap)];
+  };
+
  public:
   // --- create
   Str() = default;
   explicit Str(size_t size);
   Str(size_t size, char ch);
+  // Takes malloc'ed buffer of `capacity` bytes, first `size` of them are string.
   static Str from_raw(char* data, size_t size);
+  static Str from_raw(char* data, size_t size, size_t capacity);
 
   // --- copy
   Str(const Str& o);
@@ -60,8 +89,90 @@ class Str : public StrView {
 
   ~Str();
 
-  void resize(size_t required_size);
-  Str& null_terminate();
+  bool is_inline() const { return u8(inline_[inline_capacity]) & inline_tag; }
+
+  // Inline and heap strings are mixed in containers, so size() and data() select with
+  // mask instead of branching on is_inline().
+  bool   empty() const { return size() == 0; }
+  size_t size() const {
+    size_t inline_size = u8(inline_[inline_capacity]) & ~inline_tag;
+    return (heap_.size & ~inline_mask()) | (inline_size & inline_mask());
+  }
+  const char* data() const {
+    return (const char*)((uintptr_t(heap_.data) & ~inline_mask()) |
+                         (uintptr_t(inline_) & inline_mask()));
+  }
+  char*       data() { return const_cast<char*>(static_cast<const Str*>(this)->data()); }
+  char*       begin() { return data(); }
+  const char* begin() const { return data(); }
+  char*       end() { return data() + size(); }
+  const char* end() const { return data() + size(); }
+  char&       operator[](size_t index) { return data()[index]; }
+  const char& operator[](size_t index) const { return data()[index]; }
+
+  StrView view() const { return {data(), size()}; }
+  operator StrView() const { return view(); }
+
+  bool operator==(StrView sv) const { return view() == sv; }
+  bool operator!=(StrView sv) const { return view() != sv; }
+
+  // StrView interface
+  bool       starts_with(char c) const { return view().starts_with(c); }
+  bool       ends_with(char c) const { return view().ends_with(c); }
+  bool       starts_with(StrView sv) const { return view().starts_with(sv); }
+  bool       ends_with(StrView sv) const { return view().ends_with(sv); }
+  ComparePos compare(StrView sv) const { return view().compare(sv); }
+  ComparePos compare_ci(StrView sv) const { return view().compare_ci(sv); }
+  u64        hash() const { return view().hash(); }
+  size_t     find(char c) const { return view().find(c); }
+  size_t     find_last(char c) const { return view().find_last(c); }
+  size_t     find(StrView term) const { return view().find(term); }
+  size_t     find_last(StrView term) const { return view().find_last(term); }
+  size_t     find_any_of(StrView chars) const { return view().find_any_of(chars); }
+  StrView    trim_left() const { return view().trim_left(); }
+  StrView    trim_right() const { return view().trim_right(); }
+  StrView    trim() const { return view().trim(); }
+  StrView    to_lower() { return view().to_lower(); }
+  StrView    to_upper() { return view().to_upper(); }
+
+  StrView sub(size_t from, size_t count = UINT64_MAX) const {
+    return view().sub(from, count);
+  }
+  ArrView<StrView> split(char by, ArrView<StrView> out) const {
+    return view().split(by, out);
+  }
+  ArrView<StrView> split_se(char by, ArrView<StrView> out) const {
+    return view().split_se(by, out);
+  }
+  ArrView<StrView> split(StrView by, ArrView<StrView> out) const {
+    return view().split(by, out);
+  }
+  ArrView<StrView> split_se(StrView by, ArrView<StrView> out) const {
+    return view().split_se(by, out);
+  }
+  bool try_to_c_str(char* buf, size_t buffer_size) const {
+    return view().try_to_c_str(buf, buffer_size);
+  }
+  void to_c_str(char* buf, size_t buffer_size) const {
+    view().to_c_str(buf, buffer_size);
+  }
+
+  template <size_t buffer_size>
+  bool try_to_c_str(char (&buf)[buffer_size]) const {
+    return try_to_c_str(buf, buffer_size);
+  }
+
+  template <size_t buffer_size>
+  void to_c_str(char (&buf)[buffer_size]) const {
+    to_c_str(buf, buffer_size);
+  }
+
+  // Growing keeps capacity, grows it geometrically when it does not fit. Resizing to zero
+  // releases storage.
+  void   resize(size_t required_size);
+  void   reserve(size_t capacity);
+  size_t capacity() const;
+  Str&   null_terminate();
 
   Str& operator+=(StrView o);
 
@@ -77,8 +188,16 @@ class Str : public StrView {
     (copy(args), ...);
     return result;
   }
+
+ private:
+  size_t inline_mask() const { return 0 - size_t(is_inline()); }
+  void   set_size(size_t size);
+  void   set_capacity(size_t capacity);
+  void   release();
 };
 
+mTriviallyRelocatable(Str);
+
 inline Str operator""_s(const char* cstr, size_t size) {
   return {cstr, size};
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "cc/common.hpp"
 #include "cc/str.hpp"
+#include "cc/time.hpp"
 
 
 #define mRequire(cond)                                        \
@@ -32,6 +33,13 @@
       register_test_case(TestCase{#func, func});         \
   static void func()
 
+// Benchmark cases are skipped by default, run them with --bench.
+#define mBenchCase(func)                                 \
+  static void     func();                                \
+  static TestCase mTokenConcat(g_bench_case_, __LINE__) = \
+      register_test_case(TestCase{#func, func, true});   \
+  static void func()
+
 
 class TestCaseFail final : public std::exception {
   char* message;
@@ -45,8 +53,18 @@ class TestCaseFail final : public std::exception {
 struct TestCase {
   const char* name;
   void (*func)();
+  bool is_bench = false;
 };
 
+// Keeps value alive for optimizer, so benchmarked code is not thrown away.
+template <typename T>
+void bench_keep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Prints single benchmark result line: total time, time per op and ops per second.
+void bench_report(StrView name, size_t op_count, Time elapsed);
+
 
 TestCase register_test_case(TestCase test_case);
 int      tests_main(int argc, const char** argv);
@@ -1,5 +1,6 @@
 #pragma once
 #include "cc/common.hpp"
+#include "cc/arr-view.hpp"
 #include "cc/time.hpp"
 
 
@@ -33,6 +34,7 @@ class Thread {
   UPtr<ThreadFunc> join();
 
   static void   sleep(Time time);
+  static void   yield();
   static size_t hardware_thread_count();
 };
 
@@ -74,21 +76,63 @@ class ConditionVariable {
   ~ConditionVariable();
 
   void wait(Mutex& mutex);
+  // Returns false on timeout. May wake up spuriously, same as wait().
+  bool wait_for(Mutex& mutex, Time timeout);
   void notify_one();
   void notify_all();
+
+  template <typename TPred>
+  void wait(Mutex& mutex, TPred&& pred) {
+    while (!pred()) {
+      wait(mutex);
+    }
+  }
+
+  // Returns false if pred() is still false after timeout.
+  template <typename TPred>
+  bool wait_for(Mutex& mutex, Time timeout, TPred&& pred) {
+    Time deadline = Time::now() + timeout;
+    while (!pred()) {
+      Time now = Time::now();
+      if (!(now < deadline)) {
+        return false;
+      }
+      wait_for(mutex, deadline - now);
+    }
+    return true;
+  }
 };
 
 
+// Works with Mutex, SpinMutex, AdaptiveMutex and RwLock (exclusive).
+template <typename TMutex = Mutex>
 class LockGuard {
-  Mutex& mutex_;
-  bool   owns_;
+  TMutex& mutex_;
+  bool    owns_;
 
  public:
-  explicit LockGuard(Mutex& m);
-  ~LockGuard();
-
-  void lock();
-  void unlock();
+  explicit LockGuard(TMutex& m) : mutex_(m) {
+    mutex_.lock();
+    owns_ = true;
+  }
+  ~LockGuard() {
+    if (owns_) {
+      mutex_.unlock();
+    }
+  }
+
+  void lock() {
+    if (!owns_) {
+      mutex_.lock();
+      owns_ = true;
+    }
+  }
+  void unlock() {
+    if (owns_) {
+      mutex_.unlock();
+      owns_ = false;
+    }
+  }
 
   LockGuard(const LockGuard&)            = delete;
   LockGuard& operator=(const LockGuard&) = delete;
@@ -104,24 +148,774 @@ enum class MemoryOrder {
   SequentialConsistency,
 };
 
-class AtomicInt {
-  int value_;
+namespace details {
+  constexpr int to_builtin_memory_order(MemoryOrder order) {
+    switch (order) {
+      case MemoryOrder::Relaxed:
+        return __ATOMIC_RELAXED;
+      case MemoryOrder::Consume:
+        return __ATOMIC_CONSUME;
+      case MemoryOrder::Acquire:
+        return __ATOMIC_ACQUIRE;
+      case MemoryOrder::Release:
+        return __ATOMIC_RELEASE;
+      case MemoryOrder::AcquireRelease:
+        return __ATOMIC_ACQ_REL;
+      case MemoryOrder::SequentialConsistency:
+        return __ATOMIC_SEQ_CST;
+    }
+    return __ATOMIC_SEQ_CST;
+  }
+
+  // failed compare exchange only loads, so it cannot have release semantics
+  constexpr int to_builtin_failure_order(MemoryOrder order) {
+    switch (order) {
+      case MemoryOrder::Release:
+        return __ATOMIC_RELAXED;
+      case MemoryOrder::AcquireRelease:
+        return __ATOMIC_ACQUIRE;
+      default:
+        return to_builtin_memory_order(order);
+    }
+  }
+}  // namespace details
+
+constexpr size_t g_cache_line_size = 64;
+
+template <typename T>
+concept AtomicIntegral = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+template <typename T>
+concept AtomicValue = AtomicIntegral<T> || std::is_pointer_v<T> || std::is_same_v<T, bool>;
+
+// Lock-free value of integer, pointer or bool type, all operations are inlined compiler
+// builtins. Pass g_cache_line_size as alignment to keep independently updated atomics
+// on separate cache lines (sizeof is rounded up to alignment too).
+template <AtomicValue T, size_t alignment = alignof(T)>
+class Atomic {
+  alignas(alignment) T value_;
 
  public:
-  AtomicInt(int v = 0) : value_(v) {}
+  // integers add/sub value, pointers add/sub count of elements
+  using Delta = std::conditional_t<std::is_pointer_v<T>, s64, T>;
+
+  constexpr Atomic(T v = T()) : value_(v) {}
+
+  Atomic(const Atomic&)            = delete;
+  Atomic& operator=(const Atomic&) = delete;
 
   // Relaxed, Release, SequentialConsistency
-  void store(int v, MemoryOrder mo = MemoryOrder::Release);
+  void store(T v, MemoryOrder mo = MemoryOrder::Release) {
+    __atomic_store_n(&value_, v, details::to_builtin_memory_order(mo));
+  }
+
+  // Relaxed, Consume, Acquire, SequentialConsistency
+  T load(MemoryOrder mo = MemoryOrder::Acquire) const {
+    return __atomic_load_n(&value_, details::to_builtin_memory_order(mo));
+  }
+
+  T exchange(T v, MemoryOrder mo = MemoryOrder::SequentialConsistency) {
+    return __atomic_exchange_n(&value_, v, details::to_builtin_memory_order(mo));
+  }
+
+  // On failure writes current value to expected. Weak version may fail spuriously, use it
+  // in loops.
+  bool compare_exchange_strong(T& expected, T desired,
+                               MemoryOrder mo = MemoryOrder::SequentialConsistency) {
+    return __atomic_compare_exchange_n(&value_, &expected, desired, /*weak=*/false,
+                                       details::to_builtin_memory_order(mo),
+                                       details::to_builtin_failure_order(mo));
+  }
+  bool compare_exchange_weak(T& expected, T desired,
+                             MemoryOrder mo = MemoryOrder::SequentialConsistency) {
+    return __atomic_compare_exchange_n(&value_, &expected, desired, /*weak=*/true,
+                                       details::to_builtin_memory_order(mo),
+                                       details::to_builtin_failure_order(mo));
+  }
+
+  T fetch_add(Delta v, MemoryOrder mo = MemoryOrder::SequentialConsistency)
+    requires(!std::is_same_v<T, bool>)
+  {
+    return __atomic_fetch_add(&value_, scale(v), details::to_builtin_memory_order(mo));
+  }
+  T fetch_sub(Delta v, MemoryOrder mo = MemoryOrder::SequentialConsistency)
+    requires(!std::is_same_v<T, bool>)
+  {
+    return __atomic_fetch_sub(&value_, scale(v), details::to_builtin_memory_order(mo));
+  }
+
+  T fetch_and(T v, MemoryOrder mo = MemoryOrder::SequentialConsistency)
+    requires AtomicIntegral<T>
+  {
+    return __atomic_fetch_and(&value_, v, details::to_builtin_memory_order(mo));
+  }
+  T fetch_or(T v, MemoryOrder mo = MemoryOrder::SequentialConsistency)
+    requires AtomicIntegral<T>
+  {
+    return __atomic_fetch_or(&value_, v, details::to_builtin_memory_order(mo));
+  }
+  T fetch_xor(T v, MemoryOrder mo = MemoryOrder::SequentialConsistency)
+    requires AtomicIntegral<T>
+  {
+    return __atomic_fetch_xor(&value_, v, details::to_builtin_memory_order(mo));
+  }
+
+  operator T() const { return load(); }
+
+  Atomic& operator++()
+    requires(!std::is_same_v<T, bool>)
+  {
+    fetch_add(1);
+    return *this;
+  }
+  Atomic& operator--()
+    requires(!std::is_same_v<T, bool>)
+  {
+    fetch_sub(1);
+    return *this;
+  }
+
+ private:
+  // builtins add bytes to pointers
+  static Delta scale(Delta v) {
+    if constexpr (std::is_pointer_v<T>) {
+      return v * s64(sizeof(std::remove_pointer_t<T>));
+    } else {
+      return v;
+    }
+  }
+};
+
+using AtomicInt = Atomic<int>;
+
+inline void atomic_thread_fence(MemoryOrder mo) {
+  __atomic_thread_fence(details::to_builtin_memory_order(mo));
+}
+
+// Orders only against signal handler on the same thread, compiler barrier.
+inline void atomic_signal_fence(MemoryOrder mo) {
+  __atomic_signal_fence(details::to_builtin_memory_order(mo));
+}
+
+// Hint for CPU inside of spin-wait loop.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+// Blocks while value == expected, may wake up spuriously. Linux futex, WaitOnAddress on
+// Windows, __ulock on Apple.
+void futex_wait(Atomic<u32>& value, u32 expected);
+// Returns false on timeout.
+bool futex_wait(Atomic<u32>& value, u32 expected, Time timeout);
+void futex_wake_one(Atomic<u32>& value);
+void futex_wake_all(Atomic<u32>& value);
+
+
+// Test-and-test-and-set lock for very short critical sections. Yields after spinning for
+// a while, so preempted owner is not starved by waiters on oversubscribed cores.
+class SpinMutex {
+  Atomic<bool> locked_;
+
+ public:
+  SpinMutex() = default;
+
+  SpinMutex(const SpinMutex&)            = delete;
+  SpinMutex& operator=(const SpinMutex&) = delete;
+
+  bool try_lock() {
+    return !locked_.load(MemoryOrder::Relaxed) &&
+           !locked_.exchange(true, MemoryOrder::Acquire);
+  }
+
+  void lock() {
+    for (u32 spins = 0; !try_lock(); ++spins) {
+      if (spins < 64) {
+        cpu_relax();
+      } else {
+        Thread::yield();
+      }
+    }
+  }
+
+  void unlock() { locked_.store(false, MemoryOrder::Release); }
+};
+
+
+// Futex mutex ("Futexes Are Tricky", mutex 2): uncontended lock and unlock are single
+// atomic operations, contended lock spins briefly before parking the thread. 4 bytes.
+class AdaptiveMutex {
+  enum : u32 {
+    Unlocked,
+    Locked,
+    LockedWithWaiters,
+  };
+  Atomic<u32> state_;
+
+ public:
+  AdaptiveMutex() = default;
+
+  AdaptiveMutex(const AdaptiveMutex&)            = delete;
+  AdaptiveMutex& operator=(const AdaptiveMutex&) = delete;
+
+  bool try_lock() {
+    u32 expected = Unlocked;
+    return state_.compare_exchange_strong(expected, Locked, MemoryOrder::Acquire);
+  }
+
+  void lock() {
+    if (!try_lock()) {
+      lock_slow();
+    }
+  }
+
+  void unlock() {
+    if (state_.exchange(Unlocked, MemoryOrder::Release) == LockedWithWaiters) {
+      futex_wake_one(state_);
+    }
+  }
+
+ private:
+  void lock_slow();
+};
+
+
+// Reader-writer lock on futex. Any count of readers or one writer. Waiting writer blocks
+// new readers, so writers are not starved by read-mostly load.
+class RwLock {
+  static constexpr u32 g_writer         = 1u << 31;
+  static constexpr u32 g_writer_waiting = 1u << 30;
+  static constexpr u32 g_readers_mask   = g_writer_waiting - 1;
+
+  Atomic<u32> state_;
+  Atomic<u32> epoch_;     // changed on every unlock which may unblock waiters
+  Atomic<u32> sleepers_;  // threads inside futex_wait on epoch_
+
+ public:
+  RwLock() = default;
+
+  RwLock(const RwLock&)            = delete;
+  RwLock& operator=(const RwLock&) = delete;
+
+  bool try_lock() {
+    u32 state = state_.load(MemoryOrder::Relaxed);
+    return (state & (g_writer | g_readers_mask)) == 0 &&
+           state_.compare_exchange_strong(state, g_writer, MemoryOrder::Acquire);
+  }
+
+  void lock() {
+    if (!try_lock()) {
+      lock_slow();
+    }
+  }
+
+  void unlock() {
+    state_.fetch_and(~g_writer);
+    wake_sleepers();
+  }
+
+  bool try_lock_shared() {
+    u32 state = state_.load(MemoryOrder::Relaxed);
+    return (state & (g_writer | g_writer_waiting)) == 0 &&
+           state_.compare_exchange_strong(state, state + 1, MemoryOrder::Acquire);
+  }
+
+  void lock_shared() {
+    if (!try_lock_shared()) {
+      lock_shared_slow();
+    }
+  }
+
+  void unlock_shared() {
+    if ((state_.fetch_sub(1) & g_readers_mask) == 1) {
+      wake_sleepers();  // last reader, writer may wait
+    }
+  }
+
+ private:
+  void wake_sleepers() {
+    if (sleepers_.load(MemoryOrder::SequentialConsistency) > 0) {
+      epoch_.fetch_add(1);
+      futex_wake_all(epoch_);
+    }
+  }
+
+  void lock_slow();
+  void lock_shared_slow();
+  void sleep_while(u32 blocking_mask);
+};
+
+
+// Usage:
+//   SharedLockGuard lock(rw_lock);  // read access
+template <typename TMutex = RwLock>
+class SharedLockGuard {
+  TMutex& mutex_;
+
+ public:
+  explicit SharedLockGuard(TMutex& m) : mutex_(m) { mutex_.lock_shared(); }
+  ~SharedLockGuard() { mutex_.unlock_shared(); }
+
+  SharedLockGuard(const SharedLockGuard&)            = delete;
+  SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+};
+
+
+// Counting semaphore, release() wakes sleeping acquirers only if there are any.
+class Semaphore {
+  Atomic<u32> count_;
+  Atomic<u32> waiters_;
+
+ public:
+  explicit Semaphore(u32 count = 0) : count_(count) {}
+
+  Semaphore(const Semaphore&)            = delete;
+  Semaphore& operator=(const Semaphore&) = delete;
+
+  bool try_acquire() {
+    u32 count = count_.load(MemoryOrder::Relaxed);
+    while (count > 0) {
+      if (count_.compare_exchange_weak(count, count - 1, MemoryOrder::Acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void acquire() {
+    if (!try_acquire()) {
+      acquire_until(nullptr);
+    }
+  }
+
+  // Returns false on timeout.
+  bool try_acquire_for(Time timeout) {
+    Time deadline = Time::now() + timeout;
+    return try_acquire() || acquire_until(&deadline);
+  }
+
+  void release(u32 count = 1) {
+    count_.fetch_add(count);
+    if (waiters_.load(MemoryOrder::SequentialConsistency) > 0) {
+      count == 1 ? futex_wake_one(count_) : futex_wake_all(count_);
+    }
+  }
+
+ private:
+  // waits forever without deadline
+  bool acquire_until(const Time* deadline);
+};
+
+
+// Single-use countdown: wait() blocks until count_down() was called `count` times.
+class Latch {
+  Atomic<u32> count_;
+
+ public:
+  explicit Latch(u32 count) : count_(count) {}
+
+  Latch(const Latch&)            = delete;
+  Latch& operator=(const Latch&) = delete;
+
+  void count_down(u32 count = 1) {
+    if (count_.fetch_sub(count, MemoryOrder::AcquireRelease) == count) {
+      futex_wake_all(count_);
+    }
+  }
+
+  bool try_wait() const { return count_.load() == 0; }
+  void wait() { wait_until(nullptr); }
 
-  // Relaxed, Acquire, SequentialConsistency
-  int load(MemoryOrder mo = MemoryOrder::Acquire) const;
+  // Returns false on timeout.
+  bool wait_for(Time timeout) {
+    Time deadline = Time::now() + timeout;
+    return wait_until(&deadline);
+  }
 
-  int  fetch_add(int v, MemoryOrder mo = MemoryOrder::SequentialConsistency);
-  int  fetch_sub(int v, MemoryOrder mo = MemoryOrder::SequentialConsistency);
-  bool compare_exchange_strong(int& expected, int desired,
-                               MemoryOrder mo = MemoryOrder::SequentialConsistency);
+  void arrive_and_wait(u32 count = 1) {
+    count_down(count);
+    wait();
+  }
 
-  operator int() const { return load(); }
-  AtomicInt& operator++();
-  AtomicInt& operator--();
+ private:
+  bool wait_until(const Time* deadline);
+};
+
+
+// Reusable rendezvous of fixed count of threads: arrive_and_wait() returns once all of
+// them have arrived, then barrier is ready for the next phase.
+class Barrier {
+  u32         count_;
+  Atomic<u32> arrived_;
+  Atomic<u32> phase_;
+
+ public:
+  explicit Barrier(u32 count) : count_(count) {}
+
+  Barrier(const Barrier&)            = delete;
+  Barrier& operator=(const Barrier&) = delete;
+
+  // Returns true for exactly one thread per phase: the last one arrived.
+  bool arrive_and_wait();
+};
+
+
+// Auto-reset event: set() lets exactly one wait() through, waking it if it sleeps.
+// Signals are not counted: set() on already set event does nothing.
+class Event {
+  Atomic<u32> signaled_;
+  Atomic<u32> waiters_;
+
+ public:
+  explicit Event(bool signaled = false) : signaled_(signaled) {}
+
+  Event(const Event&)            = delete;
+  Event& operator=(const Event&) = delete;
+
+  void set() {
+    signaled_.store(1, MemoryOrder::SequentialConsistency);
+    if (waiters_.load(MemoryOrder::SequentialConsistency) > 0) {
+      futex_wake_one(signaled_);
+    }
+  }
+
+  // Consumes signal if event is set.
+  bool try_wait() {
+    u32 expected = 1;
+    return signaled_.compare_exchange_strong(expected, 0, MemoryOrder::Acquire);
+  }
+
+  void wait() {
+    if (!try_wait()) {
+      wait_until(nullptr);
+    }
+  }
+
+  // Returns false on timeout.
+  bool wait_for(Time timeout) {
+    Time deadline = Time::now() + timeout;
+    return try_wait() || wait_until(&deadline);
+  }
+
+ private:
+  bool wait_until(const Time* deadline);
+};
+
+
+// Pool of worker threads, each owning a Chase-Lev deque: worker pushes and pops own tasks
+// at the bottom, idle workers steal from the top of others. Tasks submitted from outside
+// of the pool go to a shared queue. Thread which waits for a task runs other queued tasks
+// meanwhile, so waiting from inside of a task doesn't deadlock.
+//
+// Usage:
+//   auto task = ThreadPool::global().submit(func, &data);
+//   ...
+//   ThreadPool::global().wait(task);
+class ThreadPool {
+ public:
+  struct Task;
+  struct State;
+
+  // Reference to submitted task. Handle destroyed without wait detaches the task.
+  class TaskHandle {
+    Task* task_ = nullptr;
+
+    friend class ThreadPool;
+    explicit TaskHandle(Task* task) : task_(task) {}
+
+   public:
+    TaskHandle() = default;
+    TaskHandle(TaskHandle&& other) noexcept { swap(task_, other.task_); }
+    TaskHandle& operator=(TaskHandle&& other) noexcept;
+    ~TaskHandle();
+
+    TaskHandle(const TaskHandle&)            = delete;
+    TaskHandle& operator=(const TaskHandle&) = delete;
+
+    bool is_valid() const { return task_ != nullptr; }
+    bool is_done() const;
+  };
+
+ private:
+  UPtr<State> state_;
+
+ public:
+  explicit ThreadPool(size_t workers_count);
+  // runs all queued tasks, then joins workers
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&)            = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // process-wide pool, hardware_thread_count() - 1 workers (at least one), caller
+  // thread is expected to participate via wait()
+  static ThreadPool& global();
+
+  size_t workers_count() const;
+
+  // Exception escaped from func is caught and logged (message of Err, "unknown
+  // exception" for anything else), task still counts as done and worker keeps running.
+  TaskHandle submit(void (*func)(void*), void* arg);
+
+  // runs queued tasks until given one is done, invalidates handle
+  void wait(TaskHandle& task);
+};
+
+
+namespace details {
+  inline size_t queue_capacity(size_t capacity) {
+    size_t result = 2;
+    while (result < capacity) {
+      result *= 2;
+    }
+    return result;
+  }
+}  // namespace details
+
+// Bounded lock-free queue for any count of producers and consumers (Dmitry Vyukov's
+// design). Every cell has sequence number which tells whether the cell is ready for
+// producer or consumer of given position, so push and pop each take one CAS on own index.
+// Capacity is rounded up to power of two.
+template <typename T>
+class MpmcQueue {
+  struct Cell {
+    Atomic<size_t> sequence;
+    alignas(T) u8 storage[sizeof(T)];
+
+    T& value() { return *(T*)storage; }
+  };
+
+  Cell*  cells_;
+  size_t mask_;
+
+  Atomic<size_t, g_cache_line_size> enqueue_pos_ = 0;
+  Atomic<size_t, g_cache_line_size> dequeue_pos_ = 0;
+
+ public:
+  explicit MpmcQueue(size_t capacity) {
+    capacity = details::queue_capacity(capacity);
+    cells_   = new Cell[capacity];
+    mask_    = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+      cells_[i].sequence.store(i, MemoryOrder::Relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    size_t end = enqueue_pos_.load();
+    for (size_t pos = dequeue_pos_.load(); pos != end; ++pos) {
+      cells_[pos & mask_].value().~T();
+    }
+    delete[] cells_;
+  }
+
+  MpmcQueue(const MpmcQueue&)            = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Returns false if queue is full, value is not moved then.
+  bool try_push(const T& value) { return push_value(value); }
+  bool try_push(T&& value) { return push_value(move(value)); }
+
+  // Returns false if queue is empty.
+  bool try_pop(T& out) {
+    size_t pos  = dequeue_pos_.load(MemoryOrder::Relaxed);
+    Cell*  cell = claim(dequeue_pos_, pos, 1, 1);
+    if (!cell) {
+      return false;
+    }
+    out = move(cell->value());
+    cell->value().~T();
+    cell->sequence.store(pos + mask_ + 1, MemoryOrder::Release);
+    return true;
+  }
+
+  // Moves values from the beginning of view until queue is full, returns moved count.
+  size_t try_push_batch(ArrView<T> values) {
+    size_t pos   = enqueue_pos_.load(MemoryOrder::Relaxed);
+    size_t count = claim_batch(enqueue_pos_, pos, values.size(), 0);
+    for (size_t i = 0; i < count; ++i) {
+      Cell* cell = &cells_[(pos + i) & mask_];
+      new (cell->storage) T(move(values[i]));
+      cell->sequence.store(pos + i + 1, MemoryOrder::Release);
+    }
+    return count;
+  }
+
+  // Pops up to out.size() values to the beginning of out, returns popped count.
+  size_t try_pop_batch(ArrView<T> out) {
+    size_t pos   = dequeue_pos_.load(MemoryOrder::Relaxed);
+    size_t count = claim_batch(dequeue_pos_, pos, out.size(), 1);
+    for (size_t i = 0; i < count; ++i) {
+      Cell* cell = &cells_[(pos + i) & mask_];
+      out[i]     = move(cell->value());
+      cell->value().~T();
+      cell->sequence.store(pos + i + mask_ + 1, MemoryOrder::Release);
+    }
+    return count;
+  }
+
+ private:
+  template <typename TValue>
+  bool push_value(TValue&& value) {
+    size_t pos  = enqueue_pos_.load(MemoryOrder::Relaxed);
+    Cell*  cell = claim(enqueue_pos_, pos, 1, 0);
+    if (!cell) {
+      return false;
+    }
+    new (cell->storage) T(forward<TValue>(value));
+    cell->sequence.store(pos + 1, MemoryOrder::Release);
+    return true;
+  }
+
+  // Cell at pos is ready when its sequence is pos + offset (0 for producers, 1 for
+  // consumers). Claims cell by moving index forward, pos is updated to claimed position.
+  Cell* claim(Atomic<size_t, g_cache_line_size>& index, size_t& pos, size_t count,
+              size_t offset) {
+    return claim_batch(index, pos, count, offset) ? &cells_[pos & mask_] : nullptr;
+  }
+
+  // Claims up to max_count consecutive ready cells with one CAS, returns claimed count.
+  size_t claim_batch(Atomic<size_t, g_cache_line_size>& index, size_t& pos,
+                     size_t max_count, size_t offset) {
+    if (max_count == 0) {
+      return 0;
+    }
+    while (true) {
+      size_t seq  = cells_[pos & mask_].sequence.load(MemoryOrder::Acquire);
+      s64    diff = s64(seq - (pos + offset));
+      if (diff < 0) {
+        return 0;  // full for producers, empty for consumers
+      }
+      if (diff > 0) {
+        pos = index.load(MemoryOrder::Relaxed);  // other thread took this cell
+        continue;
+      }
+
+      size_t count = 1;
+      while (count < max_count &&
+             cells_[(pos + count) & mask_].sequence.load(MemoryOrder::Acquire) ==
+                 pos + count + offset) {
+        ++count;
+      }
+      if (index.compare_exchange_weak(pos, pos + count, MemoryOrder::Relaxed)) {
+        return count;
+      }
+    }
+  }
+};
+
+// Bounded wait-free ring for exactly one producer and one consumer thread. Each side
+// keeps cached copy of the other side's index on own cache line and rereads the shared
+// index only when ring looks full or empty. Capacity is rounded up to power of two.
+template <typename T>
+class SpscRing {
+  struct Slot {
+    alignas(T) u8 storage[sizeof(T)];
+
+    T& value() { return *(T*)storage; }
+  };
+
+  Slot*  slots_;
+  size_t mask_;
+
+  struct alignas(g_cache_line_size) {
+    Atomic<size_t> tail;
+    size_t         cached_head = 0;
+  } producer_;
+
+  struct alignas(g_cache_line_size) {
+    Atomic<size_t> head;
+    size_t         cached_tail = 0;
+  } consumer_;
+
+ public:
+  explicit SpscRing(size_t capacity) {
+    capacity = details::queue_capacity(capacity);
+    slots_   = new Slot[capacity];
+    mask_    = capacity - 1;
+  }
+
+  ~SpscRing() {
+    size_t tail = producer_.tail.load();
+    for (size_t i = consumer_.head.load(); i != tail; ++i) {
+      slots_[i & mask_].value().~T();
+    }
+    delete[] slots_;
+  }
+
+  SpscRing(const SpscRing&)            = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // Producer thread only. Returns false if ring is full, value is not moved then.
+  bool try_push(const T& value) { return push_value(value); }
+  bool try_push(T&& value) { return push_value(move(value)); }
+
+  // Consumer thread only. Returns false if ring is empty.
+  bool try_pop(T& out) { return try_pop_batch(ArrView<T>(&out, 1)) == 1; }
+
+  // Producer thread only. Moves values from the beginning of view until ring is full,
+  // returns moved count.
+  size_t try_push_batch(ArrView<T> values) {
+    size_t tail  = producer_.tail.load(MemoryOrder::Relaxed);
+    size_t free  = free_count(tail, values.size());
+    size_t count = mMin(values.size(), free);
+    for (size_t i = 0; i < count; ++i) {
+      new (slots_[(tail + i) & mask_].storage) T(move(values[i]));
+    }
+    producer_.tail.store(tail + count, MemoryOrder::Release);
+    return count;
+  }
+
+  // Consumer thread only. Pops up to out.size() values to the beginning of out, returns
+  // popped count.
+  size_t try_pop_batch(ArrView<T> out) {
+    size_t head  = consumer_.head.load(MemoryOrder::Relaxed);
+    size_t used  = used_count(head, out.size());
+    size_t count = mMin(out.size(), used);
+    for (size_t i = 0; i < count; ++i) {
+      T& value = slots_[(head + i) & mask_].value();
+      out[i]   = move(value);
+      value.~T();
+    }
+    consumer_.head.store(head + count, MemoryOrder::Release);
+    return count;
+  }
+
+ private:
+  template <typename TValue>
+  bool push_value(TValue&& value) {
+    size_t tail = producer_.tail.load(MemoryOrder::Relaxed);
+    if (free_count(tail, 1) == 0) {
+      return false;
+    }
+    new (slots_[tail & mask_].storage) T(forward<TValue>(value));
+    producer_.tail.store(tail + 1, MemoryOrder::Release);
+    return true;
+  }
+
+  // rereads consumer index only if cached one doesn't give enough space
+  size_t free_count(size_t tail, size_t wanted) {
+    size_t count = capacity() - (tail - producer_.cached_head);
+    if (count < wanted) {
+      producer_.cached_head = consumer_.head.load(MemoryOrder::Acquire);
+      count                 = capacity() - (tail - producer_.cached_head);
+    }
+    return count;
+  }
+
+  size_t used_count(size_t head, size_t wanted) {
+    size_t count = consumer_.cached_tail - head;
+    if (count < wanted) {
+      consumer_.cached_tail = producer_.tail.load(MemoryOrder::Acquire);
+      count                 = consumer_.cached_tail - head;
+    }
+    return count;
+  }
 };
@@ -3,12 +3,6 @@
 // verstable adaptation for c++.
 // see LICENSE.verstable for more information.
 
-#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
-  #include <intrin.h>
-  #pragma intrinsic(_BitScanForward64)
-  #pragma intrinsic(_BitScanReverse64)
-#endif
-
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wsign-conversion"
 #pragma clang diagnostic ignored "-Wimplicit-int-float-conversion"
@@ -17,92 +11,12 @@
 
 using namespace details;
 
-namespace {
-  constexpr u16    g_vt_empty                       = 0x0000;
-  constexpr u16    g_vt_hash_frag_mask              = 0xF000;
-  constexpr u16    g_vt_in_home_bucket_mask         = 0x0800;
-  constexpr u16    g_vt_displacement_mask           = 0x07FF;
-  constexpr u16    g_vt_empty_placeholder_metadatum = g_vt_empty;
-  constexpr size_t g_vt_min_nonzero_bucket_count    = 8;
-  constexpr f64    g_vt_max_load                    = 0.9;
-
-  u16 vt_hashfrag(u64 hash) {
-    return (hash >> 48) & g_vt_hash_frag_mask;
-  }
-
-  size_t vt_quadratic(u16 displacement) {
-    return ((size_t)displacement * displacement + displacement) / 2;
-  }
-
-  size_t vt_min_bucket_count_for_size(size_t size) {
-    if (size == 0) {
-      return 0;
-    }
-    // Round up to a power of two.
-    size_t bucket_count = g_vt_min_nonzero_bucket_count;
-    while (size > bucket_count * g_vt_max_load) {
-      bucket_count *= 2;
-    }
-    return bucket_count;
-  }
-
-#if defined(__GNUC__) && ULLONG_MAX == 0xFFFFFFFFFFFFFFFF
-  int vt_first_nonzero_uint16(u64 val) {
-    const u16 endian_checker = 0x0001;
-    // Little-endian (the compiler will optimize away
-    // the check at -O1 and above).
-    if (*(const char*)&endian_checker) {
-      return __builtin_ctzll(val) / 16;
-    }
-    return __builtin_clzll(val) / 16;
-  }
-#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
-  int vt_first_nonzero_uint16(u64 val) {
-    unsigned long result;
-
-    const u16 endian_checker = 0x0001;
-    if (*(const char*)&endian_checker) {
-      _BitScanForward64(&result, val);
-    } else {
-      _BitScanReverse64(&result, val);
-      result = 63 - result;
-    }
-
-    return result / 16;
-  }
-
-#else
-  int vt_first_nonzero_uint16(u64 val) {
-    int result = 0;
-
-    uint32_t half;
-    memcpy(&half, &val, sizeof(uint32_t));
-    if (!half) result += 2;
-
-    u16 quarter;
-    memcpy(&quarter, (char*)&val + result * sizeof(u16), sizeof(u16));
-    if (!quarter) result += 1;
-
-    return result;
-  }
-#endif
-}  // namespace
-
 
 void DictVItr::fast_forward() {
-  while (true) {
-    u64 metadata2;
-    memcpy(&metadata2, metadatum_, sizeof(u64));
-    if (metadata2) {
-      int offset = vt_first_nonzero_uint16(metadata2);
-      data_      = static_cast<u8*>(data_) + offset * vtable_->bucket_size;
-      metadatum_ += offset;
-      home_bucket_ = SIZE_MAX;
-      return;
-    }
-    data_ = static_cast<u8*>(data_) + 4 * vtable_->bucket_size;
-    metadatum_ += 4;
-  }
+  size_t offset = vt_skip_empty(metadatum_);
+  data_         = static_cast<u8*>(data_) + offset * vtable_->bucket_size;
+  metadatum_ += offset;
+  home_bucket_ = SIZE_MAX;
 }
 
 DictVItr& DictVItr::operator++() {
@@ -128,8 +42,10 @@ bool DictV::init(const DictV& other) {
 
   buckets_  = allocation;
   metadata_ = (u16*)((u8*)allocation + metadata_offset());
+  // padding too: sentinel stops iteration
+  memcpy(metadata_, other.metadata_,
+         (bucket_count() + g_vt_metadata_padding) * sizeof(u16));
   for (size_t i = 0; i < bucket_count(); ++i) {
-    metadata_[i] = other.metadata_[i];
     if (metadata_[i] != g_vt_empty) {
       vtable_->copy_key(get_bucket_key(get_bucket(i)),
                         other.get_bucket_key(other.get_bucket(i)));
@@ -189,8 +105,11 @@ DictVItr DictV::insert(void* key, void* value) {
   }
 }
 
-DictVItr DictV::get(void* key) {
-  u64    hash        = vtable_->hash(key);
+DictVItr DictV::get(void* key) const {
+  return get(vtable_->hash(key), key, vtable_->equals_key);
+}
+
+DictVItr DictV::get(u64 hash, void* key, bool (*equals_key)(void* a, void* b)) const {
   size_t home_bucket = hash & buckets_mask_;
 
   if (!(metadata_[home_bucket] & g_vt_in_home_bucket_mask)) {
@@ -202,7 +121,7 @@ DictVItr DictV::get(void* key) {
 
   while (true) {
     if ((metadata_[bucket] & g_vt_hash_frag_mask) == hashfrag &&
-        vtable_->equals_key(get_bucket_key(get_bucket(bucket)), key)) {
+        equals_key(get_bucket_key(get_bucket(bucket)), key)) {
       DictVItr itr;
       itr.data_         = get_bucket(bucket);
       itr.metadatum_    = metadata_ + bucket;
@@ -282,7 +201,11 @@ bool DictV::erase_itr_raw(DictVItr itr) {
 }
 
 bool DictV::erase(void* key) {
-  DictVItr itr = get(key);
+  return erase(vtable_->hash(key), key, vtable_->equals_key);
+}
+
+bool DictV::erase(u64 hash, void* key, bool (*equals_key)(void* a, void* b)) {
+  DictVItr itr = get(hash, key, equals_key);
   if (itr.is_end()) {
     return false;
   }
@@ -310,7 +233,7 @@ DictVItr DictV::begin() const {
 }
 
 size_t DictV::total_alloc_size() const {
-  return metadata_offset() + (buckets_mask_ + 1 + 4) * sizeof(u16);
+  return metadata_offset() + (buckets_mask_ + 1 + g_vt_metadata_padding) * sizeof(u16);
 }
 
 size_t DictV::size() const {
@@ -339,18 +262,7 @@ u8* DictV::get_bucket_value(u8* b) const {
 }
 
 bool DictV::find_first_empty(size_t home_bucket, size_t& empty, u16& displacement) const {
-  displacement               = 1;
-  size_t linear_displacement = 1;
-  while (true) {
-    empty = (home_bucket + linear_displacement) & buckets_mask_;
-    if (metadata_[empty] == g_vt_empty) {
-      return true;
-    }
-    if (++displacement == g_vt_displacement_mask) {
-      return false;
-    }
-    linear_displacement += displacement;
-  }
+  return vt_find_first_empty(metadata_, buckets_mask_, home_bucket, empty, displacement);
 }
 
 size_t DictV::find_insert_location_in_chain(size_t home_bucket,
@@ -486,7 +398,8 @@ bool DictV::rehash(size_t bucket_count) {
     new_table.buckets_ = (u8*)allocation;
     new_table.metadata_ =
         (u16*)((unsigned char*)allocation + new_table.metadata_offset());
-    memset(new_table.metadata_, 0x00, (bucket_count + 4) * sizeof(u16));
+    memset(new_table.metadata_, 0x00,
+           (bucket_count + g_vt_metadata_padding) * sizeof(u16));
     new_table.metadata_[bucket_count] = 0x01;
 
     for (size_t bucket = 0; bucket < this->bucket_count(); ++bucket) {
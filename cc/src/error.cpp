@@ -88,7 +88,9 @@ namespace {
         FD(STDOUT_FILENO).redirect_to(pipes.writefd());
         FD(STDERR_FILENO).redirect_to(pipes.writefd());
         ::execv(prog_name, argp);
-        ::exit(0);
+        // no atexit handlers and static destructors in forked child: they would join
+        // threads which exist only in parent
+        ::_exit(127);
       }
 
       pipes.writefd().close();
@@ -650,6 +650,14 @@ Path operator/(StrView a, const Path& b) {
   return Path::join(a, b);
 }
 
+Path operator/(const Path& a, const Str& b) {
+  return Path::join(a, b);
+}
+
+Path operator/(const Str& a, const Path& b) {
+  return Path::join(a, b);
+}
+
 File::File(const Path& path, const char* mode) {
   open(path, mode);
 }
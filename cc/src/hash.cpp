@@ -1,182 +1,245 @@
 #include "cc/hash.hpp"
 
-// This file contains portions of wyhash library which is licenses under The Unlicense
-// (http://unlicense.org/)
-// main repo: https://github.com/wangyi-fudan/wyhash
+// CRC32 bulk paths are picked at runtime by CPU features on x86-64, so binaries built for
+// baseline x86-64 still use SSE4.2 crc32 and PCLMUL when CPU has them.
+#if defined(__x86_64__) || defined(_M_X64)
+  #define mCrcX64 1
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+  #include <immintrin.h>
+  #if defined(__GNUC__) || defined(__clang__)
+    #define mCrcTarget(features) __attribute__((target(features)))
+  #else
+    #define mCrcTarget(features)
+  #endif
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// CRC32
+//
+// Bytewise table method is from crc32.c of zlib by Jean-loup Gailly and Mark Adler,
+// slicing extends it to 16 tables. PCLMUL folding is from Intel "Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ Instruction" (Gopal et al., 2009), as in zlib
+// crc32_simd.c.
+//
+// Internally crc is kept inverted (~crc), so that every path is plain polynomial division
+// with zero initial state.
 
 namespace {
-  void vt_wymum(u64* a, u64* b) {
-#if defined(__SIZEOF_INT128__)
-    __uint128_t r = *a;
-    r *= *b;
-    *a = (u64)r;
-    *b = (u64)(r >> 64);
-#elif defined(_MSC_VER) && defined(_M_X64)
-    *a = _umul128(*a, *b, b);
-#else
-    u64 ha  = *a >> 32;
-    u64 hb  = *b >> 32;
-    u64 la  = (u32)*a;
-    u64 lb  = (u32)*b;
-    u64 rh  = ha * hb;
-    u64 rm0 = ha * lb;
-    u64 rm1 = hb * la;
-    u64 rl  = la * lb;
-    u64 t   = rl + (rm0 << 32);
-    u64 c   = t < rl;
-    u64 lo  = t + (rm1 << 32);
-    c += lo < t;
-    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
-    *a          = lo;
-    *b          = hi;
-#endif
+  // bit reflected polynomials
+  constexpr u32 g_crc32_poly  = 0xedb88320;  // CRC-32: zlib, gzip, png, ethernet
+  constexpr u32 g_crc32c_poly = 0x82f63b78;  // CRC-32C: Castagnoli, SSE4.2 crc32
+
+  // Slicing by 16: values[k][b] is crc of byte b followed by k zero bytes, so 16 input
+  // bytes take 16 independent lookups instead of a chain of 16 dependent ones.
+  constexpr size_t g_crc_slices = 16;
+
+  struct CrcTables {
+    u32 values[g_crc_slices][256];
+  };
+
+  constexpr CrcTables make_crc_tables(u32 poly) {
+    CrcTables tables{};
+    for (u32 i = 0; i < 256; ++i) {
+      u32 crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+      }
+      tables.values[0][i] = crc;
+    }
+    for (size_t k = 1; k < g_crc_slices; ++k) {
+      for (u32 i = 0; i < 256; ++i) {
+        u32 prev             = tables.values[k - 1][i];
+        tables.values[k][i] = (prev >> 8) ^ tables.values[0][prev & 0xff];
+      }
+    }
+    return tables;
+  }
+
+  constexpr CrcTables g_crc32_tables  = make_crc_tables(g_crc32_poly);
+  constexpr CrcTables g_crc32c_tables = make_crc_tables(g_crc32c_poly);
+
+  static_assert(g_crc32_tables.values[0][1] == 0x77073096);  // zlib table
+  static_assert(g_crc32_tables.values[0][255] == 0x2d02ef8d);
+
+  u32 crc_load32(const u8* p) {
+    return u32(p[0]) | u32(p[1]) << 8 | u32(p[2]) << 16 | u32(p[3]) << 24;
+  }
+
+  u32 crc_slicing(u32 crc, const u8* buf, size_t len, const CrcTables& tables) {
+    const auto& t = tables.values;
+    while (len >= 16) {
+      u32 a = crc ^ crc_load32(buf);
+      crc   = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^
+            t[12][a >> 24] ^ t[11][buf[4]] ^ t[10][buf[5]] ^ t[9][buf[6]] ^ t[8][buf[7]] ^
+            t[7][buf[8]] ^ t[6][buf[9]] ^ t[5][buf[10]] ^ t[4][buf[11]] ^ t[3][buf[12]] ^
+            t[2][buf[13]] ^ t[1][buf[14]] ^ t[0][buf[15]];
+      buf += 16;
+      len -= 16;
+    }
+    while (len--) {
+      crc = t[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
   }
 
-  u64 vt_wymix(u64 a, u64 b) {
-    vt_wymum(&a, &b);
-    return a ^ b;
+  // Carry-less multiplication constants for folding: x^exponent mod P, bit reflected and
+  // shifted by one as pclmulqdq expects.
+  constexpr u64 crc_fold_key(u32 poly, int exponent) {
+    u32 value = 0x80000000;  // x^0
+    for (int i = 0; i < exponent; ++i) {
+      value = (value >> 1) ^ (value & 1 ? poly : 0);
+    }
+    return u64(value) << 1;
   }
 
-  u64 vt_wyr8(const unsigned char* p) {
-    u64 v;
-    memcpy(&v, p, 8);
-    return v;
+  struct CrcFoldKeys {
+    u64 by4[2];  // fold 128 bit lane forward over 4 lanes (512 bits)
+    u64 by1[2];  // fold over 1 lane (128 bits)
+  };
+
+  constexpr CrcFoldKeys make_crc_fold_keys(u32 poly) {
+    return {{crc_fold_key(poly, 512 + 32), crc_fold_key(poly, 512 - 32)},
+            {crc_fold_key(poly, 128 + 32), crc_fold_key(poly, 128 - 32)}};
   }
 
-  u64 vt_wyr4(const unsigned char* p) {
-    u32 v;
-    memcpy(&v, p, 4);
-    return v;
+  constexpr CrcFoldKeys g_crc32_fold_keys  = make_crc_fold_keys(g_crc32_poly);
+  constexpr CrcFoldKeys g_crc32c_fold_keys = make_crc_fold_keys(g_crc32c_poly);
+
+  static_assert(g_crc32_fold_keys.by4[0] == 0x154442bd4 &&  // Intel paper, zlib
+                g_crc32_fold_keys.by4[1] == 0x1c6e41596 &&
+                g_crc32_fold_keys.by1[0] == 0x1751997d0 &&
+                g_crc32_fold_keys.by1[1] == 0x0ccaa009e);
+
+#if mCrcX64
+  // Folding starts with 4 lanes, below that setup costs more than it saves.
+  constexpr size_t g_crc32_fold_min_size  = 64;
+  constexpr size_t g_crc32c_fold_min_size = 512;  // crc32 instruction is fast already
+
+  struct CpuFeatures {
+    bool sse42  = false;
+    bool pclmul = false;
+  };
+
+  const CpuFeatures& cpu_features() {
+    static const CpuFeatures features = [] {
+      unsigned int regs[4] = {};
+  #if defined(_MSC_VER)
+      __cpuid(reinterpret_cast<int*>(regs), 1);
+  #else
+      __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+  #endif
+      CpuFeatures result;
+      result.sse42  = (regs[2] >> 20) & 1;
+      result.pclmul = (regs[2] >> 1) & 1;
+      return result;
+    }();
+    return features;
   }
 
-  u64 vt_wyr3(const unsigned char* p, size_t k) {
-    return (((u64)p[0]) << 16) | (((u64)p[k >> 1]) << 8) | p[k - 1];
+  mCrcTarget("sse2,pclmul") __m128i crc_fold_lane(__m128i lane, __m128i keys,
+                                                  __m128i next) {
+    __m128i lo = _mm_clmulepi64_si128(lane, keys, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(lane, keys, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
   }
-}  // namespace
 
-// wyhash
-u64 cc::hash_wy(const void* key, size_t len) {
-  const auto* p    = (const unsigned char*)key;
-  u64    seed = 0xca813bf4c7abf0a9ull;
-  u64    a;
-  u64    b;
-  if (len <= 16) {
-    if (len >= 4) {
-      a = (vt_wyr4(p) << 32) | vt_wyr4(p + ((len >> 3) << 2));
-      b = (vt_wyr4(p + len - 4) << 32) | vt_wyr4(p + len - 4 - ((len >> 3) << 2));
-    } else if ((len > 0)) {
-      a = vt_wyr3(p, len);
-      b = 0;
-    } else {
-      a = 0;
-      b = 0;
+  // Folds len bytes (multiple of 16, at least 64) down to 16 bytes with the same crc.
+  mCrcTarget("sse2,pclmul") void crc_fold(u32 crc, const u8* buf, size_t len,
+                                          const CrcFoldKeys& keys, u8 (&out)[16]) {
+    auto load = [](const u8* p) { return _mm_loadu_si128((const __m128i*)p); };
+
+    __m128i x0 = _mm_xor_si128(load(buf), _mm_cvtsi32_si128(int(crc)));
+    __m128i x1 = load(buf + 16);
+    __m128i x2 = load(buf + 32);
+    __m128i x3 = load(buf + 48);
+    buf += 64;
+    len -= 64;
+
+    __m128i by4 = _mm_set_epi64x(s64(keys.by4[1]), s64(keys.by4[0]));
+    while (len >= 64) {
+      x0 = crc_fold_lane(x0, by4, load(buf));
+      x1 = crc_fold_lane(x1, by4, load(buf + 16));
+      x2 = crc_fold_lane(x2, by4, load(buf + 32));
+      x3 = crc_fold_lane(x3, by4, load(buf + 48));
+      buf += 64;
+      len -= 64;
     }
-  } else {
-    size_t i = len;
-    if (i >= 48) {
-      u64 see1 = seed;
-      u64 see2 = seed;
-      do {
-        seed = vt_wymix(vt_wyr8(p) ^ 0x8bb84b93962eacc9ull, vt_wyr8(p + 8) ^ seed);
-        see1 = vt_wymix(vt_wyr8(p + 16) ^ 0x4b33a62ed433d4a3ull, vt_wyr8(p + 24) ^ see1);
-        see2 = vt_wymix(vt_wyr8(p + 32) ^ 0x4d5a2da51de1aa47ull, vt_wyr8(p + 40) ^ see2);
-        p += 48;
-        i -= 48;
-      } while (i >= 48);
-      seed ^= see1 ^ see2;
+
+    __m128i by1 = _mm_set_epi64x(s64(keys.by1[1]), s64(keys.by1[0]));
+    x0          = crc_fold_lane(x0, by1, x1);
+    x0          = crc_fold_lane(x0, by1, x2);
+    x0          = crc_fold_lane(x0, by1, x3);
+    while (len >= 16) {
+      x0 = crc_fold_lane(x0, by1, load(buf));
+      buf += 16;
+      len -= 16;
+    }
+    _mm_storeu_si128((__m128i*)out, x0);
+  }
+
+  mCrcTarget("sse4.2") u32 crc32c_sse42(u32 crc, const u8* buf, size_t len) {
+    u64 crc64 = crc;
+    while (len >= 8) {
+      u64 value;
+      memcpy(&value, buf, 8);
+      crc64 = _mm_crc32_u64(crc64, value);
+      buf += 8;
+      len -= 8;
     }
-    while (i > 16) {
-      seed = vt_wymix(vt_wyr8(p) ^ 0x8bb84b93962eacc9ull, vt_wyr8(p + 8) ^ seed);
-      i -= 16;
-      p += 16;
+    crc = u32(crc64);
+    while (len--) {
+      crc = _mm_crc32_u8(crc, *buf++);
     }
-    a = vt_wyr8(p + i - 16);
-    b = vt_wyr8(p + i - 8);
+    return crc;
   }
-  a ^= 0x8bb84b93962eacc9ull;
-  b ^= seed;
-  vt_wymum(&a, &b);
-  return (u64)vt_wymix(a ^ 0x2d358dccaa6c78a5ull ^ len, b ^ 0x8bb84b93962eacc9ull);
-}
+#endif
 
+  u32 crc32_inverted(u32 crc, const u8* buf, size_t len) {
+#if mCrcX64
+    if (len >= g_crc32_fold_min_size && cpu_features().pclmul) {
+      u8     folded[16];
+      size_t fold_len = len & ~size_t(15);
+      crc_fold(crc, buf, fold_len, g_crc32_fold_keys, folded);
+      crc = crc_slicing(0, folded, 16, g_crc32_tables);
+      buf += fold_len;
+      len -= fold_len;
+    }
+#endif
+    return crc_slicing(crc, buf, len, g_crc32_tables);
+  }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////
-// CRC32
-/*
- * This file is derived from crc32.c from the zlib-1.1.3 distribution
- * by Jean-loup Gailly and Mark Adler.
- *
- * crc32.c -- compute the CRC-32 of a data stream
- * Copyright (C) 1995-1998 Mark Adler
- * For conditions of distribution and use, see copyright notice in zlib.h
- */
-
-static constexpr u32 g_crc_table[256] = {
-    0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L, 0x706af48fL,
-    0xe963a535L, 0x9e6495a3L, 0x0edb8832L, 0x79dcb8a4L, 0xe0d5e91eL, 0x97d2d988L,
-    0x09b64c2bL, 0x7eb17cbdL, 0xe7b82d07L, 0x90bf1d91L, 0x1db71064L, 0x6ab020f2L,
-    0xf3b97148L, 0x84be41deL, 0x1adad47dL, 0x6ddde4ebL, 0xf4d4b551L, 0x83d385c7L,
-    0x136c9856L, 0x646ba8c0L, 0xfd62f97aL, 0x8a65c9ecL, 0x14015c4fL, 0x63066cd9L,
-    0xfa0f3d63L, 0x8d080df5L, 0x3b6e20c8L, 0x4c69105eL, 0xd56041e4L, 0xa2677172L,
-    0x3c03e4d1L, 0x4b04d447L, 0xd20d85fdL, 0xa50ab56bL, 0x35b5a8faL, 0x42b2986cL,
-    0xdbbbc9d6L, 0xacbcf940L, 0x32d86ce3L, 0x45df5c75L, 0xdcd60dcfL, 0xabd13d59L,
-    0x26d930acL, 0x51de003aL, 0xc8d75180L, 0xbfd06116L, 0x21b4f4b5L, 0x56b3c423L,
-    0xcfba9599L, 0xb8bda50fL, 0x2802b89eL, 0x5f058808L, 0xc60cd9b2L, 0xb10be924L,
-    0x2f6f7c87L, 0x58684c11L, 0xc1611dabL, 0xb6662d3dL, 0x76dc4190L, 0x01db7106L,
-    0x98d220bcL, 0xefd5102aL, 0x71b18589L, 0x06b6b51fL, 0x9fbfe4a5L, 0xe8b8d433L,
-    0x7807c9a2L, 0x0f00f934L, 0x9609a88eL, 0xe10e9818L, 0x7f6a0dbbL, 0x086d3d2dL,
-    0x91646c97L, 0xe6635c01L, 0x6b6b51f4L, 0x1c6c6162L, 0x856530d8L, 0xf262004eL,
-    0x6c0695edL, 0x1b01a57bL, 0x8208f4c1L, 0xf50fc457L, 0x65b0d9c6L, 0x12b7e950L,
-    0x8bbeb8eaL, 0xfcb9887cL, 0x62dd1ddfL, 0x15da2d49L, 0x8cd37cf3L, 0xfbd44c65L,
-    0x4db26158L, 0x3ab551ceL, 0xa3bc0074L, 0xd4bb30e2L, 0x4adfa541L, 0x3dd895d7L,
-    0xa4d1c46dL, 0xd3d6f4fbL, 0x4369e96aL, 0x346ed9fcL, 0xad678846L, 0xda60b8d0L,
-    0x44042d73L, 0x33031de5L, 0xaa0a4c5fL, 0xdd0d7cc9L, 0x5005713cL, 0x270241aaL,
-    0xbe0b1010L, 0xc90c2086L, 0x5768b525L, 0x206f85b3L, 0xb966d409L, 0xce61e49fL,
-    0x5edef90eL, 0x29d9c998L, 0xb0d09822L, 0xc7d7a8b4L, 0x59b33d17L, 0x2eb40d81L,
-    0xb7bd5c3bL, 0xc0ba6cadL, 0xedb88320L, 0x9abfb3b6L, 0x03b6e20cL, 0x74b1d29aL,
-    0xead54739L, 0x9dd277afL, 0x04db2615L, 0x73dc1683L, 0xe3630b12L, 0x94643b84L,
-    0x0d6d6a3eL, 0x7a6a5aa8L, 0xe40ecf0bL, 0x9309ff9dL, 0x0a00ae27L, 0x7d079eb1L,
-    0xf00f9344L, 0x8708a3d2L, 0x1e01f268L, 0x6906c2feL, 0xf762575dL, 0x806567cbL,
-    0x196c3671L, 0x6e6b06e7L, 0xfed41b76L, 0x89d32be0L, 0x10da7a5aL, 0x67dd4accL,
-    0xf9b9df6fL, 0x8ebeeff9L, 0x17b7be43L, 0x60b08ed5L, 0xd6d6a3e8L, 0xa1d1937eL,
-    0x38d8c2c4L, 0x4fdff252L, 0xd1bb67f1L, 0xa6bc5767L, 0x3fb506ddL, 0x48b2364bL,
-    0xd80d2bdaL, 0xaf0a1b4cL, 0x36034af6L, 0x41047a60L, 0xdf60efc3L, 0xa867df55L,
-    0x316e8eefL, 0x4669be79L, 0xcb61b38cL, 0xbc66831aL, 0x256fd2a0L, 0x5268e236L,
-    0xcc0c7795L, 0xbb0b4703L, 0x220216b9L, 0x5505262fL, 0xc5ba3bbeL, 0xb2bd0b28L,
-    0x2bb45a92L, 0x5cb36a04L, 0xc2d7ffa7L, 0xb5d0cf31L, 0x2cd99e8bL, 0x5bdeae1dL,
-    0x9b64c2b0L, 0xec63f226L, 0x756aa39cL, 0x026d930aL, 0x9c0906a9L, 0xeb0e363fL,
-    0x72076785L, 0x05005713L, 0x95bf4a82L, 0xe2b87a14L, 0x7bb12baeL, 0x0cb61b38L,
-    0x92d28e9bL, 0xe5d5be0dL, 0x7cdcefb7L, 0x0bdbdf21L, 0x86d3d2d4L, 0xf1d4e242L,
-    0x68ddb3f8L, 0x1fda836eL, 0x81be16cdL, 0xf6b9265bL, 0x6fb077e1L, 0x18b74777L,
-    0x88085ae6L, 0xff0f6a70L, 0x66063bcaL, 0x11010b5cL, 0x8f659effL, 0xf862ae69L,
-    0x616bffd3L, 0x166ccf45L, 0xa00ae278L, 0xd70dd2eeL, 0x4e048354L, 0x3903b3c2L,
-    0xa7672661L, 0xd06016f7L, 0x4969474dL, 0x3e6e77dbL, 0xaed16a4aL, 0xd9d65adcL,
-    0x40df0b66L, 0x37d83bf0L, 0xa9bcae53L, 0xdebb9ec5L, 0x47b2cf7fL, 0x30b5ffe9L,
-    0xbdbdf21cL, 0xcabac28aL, 0x53b39330L, 0x24b4a3a6L, 0xbad03605L, 0xcdd70693L,
-    0x54de5729L, 0x23d967bfL, 0xb3667a2eL, 0xc4614ab8L, 0x5d681b02L, 0x2a6f2b94L,
-    0xb40bbe37L, 0xc30c8ea1L, 0x5a05df1bL, 0x2d02ef8dL};
+  u32 crc32c_inverted(u32 crc, const u8* buf, size_t len) {
+#if mCrcX64
+    if (cpu_features().sse42) {
+      if (len >= g_crc32c_fold_min_size && cpu_features().pclmul) {
+        u8     folded[16];
+        size_t fold_len = len & ~size_t(15);
+        crc_fold(crc, buf, fold_len, g_crc32c_fold_keys, folded);
+        crc = crc32c_sse42(0, folded, 16);
+        buf += fold_len;
+        len -= fold_len;
+      }
+      return crc32c_sse42(crc, buf, len);
+    }
+#endif
+    return crc_slicing(crc, buf, len, g_crc32c_tables);
+  }
+}  // namespace
+
+u32 cc::crc32_update(u32 crc, const void* data, size_t len) {
+  return ~crc32_inverted(~crc, static_cast<const u8*>(data), len);
+}
+
+u32 cc::crc32c_update(u32 crc, const void* data, size_t len) {
+  return ~crc32c_inverted(~crc, static_cast<const u8*>(data), len);
+}
 
 u32 cc::hash_crc32(const void* data, size_t len) {
-  u32 seed = 0xca813bf4ul;
-
-  const auto* buf = (const u8*)data;
-  u32         crc = seed ^ 0xffffffffL;
-  while (len >= 8) {
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-    len -= 8;
-  }
-  while (len--) {
-    crc = g_crc_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-  }
-  crc ^= 0xffffffffL;
-  return crc;
+  return crc32_update(0xca813bf4ul, data, len);
 }
 
 // https://github.com/lcn2/fnv
@@ -190,27 +253,3 @@ u32 cc::hash_fnv32(const void* data, size_t len) {
   }
   return hval;
 }
-
-template <>
-u64 cc::hash<u64>(const u64& key) {
-  u64 tmp = key;
-  tmp ^= tmp >> 23;
-  tmp *= 0x2127599bf4325c37ull;
-  tmp ^= tmp >> 47;
-  return tmp;
-}
-
-template <>
-u64 cc::hash<s64>(const s64& key) {
-  return hash<u64>(reinterpret_cast<const u64&>(key));
-}
-
-template <>
-u64 cc::hash<u32>(const u32& key) {
-  return hash<u64>(u64(key));
-}
-
-template <>
-u64 cc::hash<s32>(const s32& key) {
-  return hash<u64>(u64(reinterpret_cast<const u32&>(key)));
-}
@@ -6,6 +6,21 @@
 #include "cc/error.hpp"
 #include <cctype>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  #include <intrin.h>
+  #pragma intrinsic(_BitScanForward64)
+#endif
+
+// Searches compare 32 (AVX2) or 16 (SSE2) bytes at once, memchr/scalar code otherwise.
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define mStrAvx2 1
+  #define mStrSse2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define mStrSse2 1
+#endif
+
 namespace {
   // independent implementation of strnicmp, because it is not available on some platforms
   int str_compare_ci(const char* s1, const char* s2, size_t len) {
@@ -26,6 +41,109 @@ namespace {
 #ifdef _DEBUG
   Dict<u64, Str> g_string_hashes;
 #endif
+
+#if defined(mStrSse2)
+  int first_set_bit64(u64 val) {
+  #if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long result;
+    _BitScanForward64(&result, val);
+    return int(result);
+  #else
+    return __builtin_ctzll(val);
+  #endif
+  }
+#endif
+
+#if defined(mStrAvx2)
+  using Block                   = __m256i;
+  constexpr size_t g_block_size = 32;
+
+  Block load(const char* p) { return _mm256_loadu_si256((const __m256i*)p); }
+  Block splat(char c) { return _mm256_set1_epi8(c); }
+
+  // Bit i is set when a[i] == b[i].
+  u32 eq_mask(Block a, Block b) {
+    return u32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+  }
+#elif defined(mStrSse2)
+  using Block                   = __m128i;
+  constexpr size_t g_block_size = 16;
+
+  Block load(const char* p) { return _mm_loadu_si128((const __m128i*)p); }
+  Block splat(char c) { return _mm_set1_epi8(c); }
+
+  // Bit i is set when a[i] == b[i].
+  u32 eq_mask(Block a, Block b) { return u32(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))); }
+#endif
+
+  // Max count of chars for which find_any_of compares blocks with each char, larger sets
+  // go through byte table.
+  constexpr size_t g_find_any_of_simd_max = 8;
+
+  const char* find_byte(const char* begin, const char* end, char c) {
+#if defined(mStrSse2)
+    // 64 bytes per iteration, so loads of several blocks overlap
+    Block       needle = splat(c);
+    const char* it     = begin;
+    for (; end - it >= 64; it += 64) {
+      u64 mask = 0;
+      for (size_t block = 0; block < 64 / g_block_size; ++block) {
+        mask |= u64(eq_mask(load(it + block * g_block_size), needle))
+                << (block * g_block_size);
+      }
+      if (mask) {
+        return it + first_set_bit64(mask);
+      }
+    }
+    for (; size_t(end - it) >= g_block_size; it += g_block_size) {
+      if (u32 mask = eq_mask(load(it), needle)) {
+        return it + first_set_bit64(mask);
+      }
+    }
+    for (; it != end; ++it) {
+      if (*it == c) {
+        return it;
+      }
+    }
+    return nullptr;
+#else
+    return static_cast<const char*>(memchr(begin, c, size_t(end - begin)));
+#endif
+  }
+
+  // Substring of 2+ chars, text is not shorter than term. Blocks of positions where both
+  // first and last chars of term match are filtered at once, only those positions are
+  // compared in full.
+  size_t find_substr(const char* text, size_t text_size, const char* term,
+                     size_t term_size) {
+    size_t i = 0;
+#if defined(mStrSse2)
+    Block first = splat(term[0]);
+    Block last  = splat(term[term_size - 1]);
+    for (; i + term_size - 1 + g_block_size <= text_size; i += g_block_size) {
+      u32 mask = eq_mask(load(text + i), first) &
+                 eq_mask(load(text + i + term_size - 1), last);
+      while (mask) {
+        size_t pos = i + size_t(first_set_bit64(mask));
+        if (memcmp(text + pos + 1, term + 1, term_size - 2) == 0) {
+          return pos;
+        }
+        mask &= mask - 1;
+      }
+    }
+#endif
+    const char* end = text + text_size - term_size + 1;
+    for (const char* it = text + i; it != end; ++it) {
+      it = find_byte(it, end, term[0]);
+      if (!it) {
+        break;
+      }
+      if (memcmp(it + 1, term + 1, term_size - 1) == 0) {
+        return size_t(it - text);
+      }
+    }
+    return StrView::npos;
+  }
 }  // namespace
 
 StrView::StrView(const char* str) {
@@ -37,24 +155,6 @@ StrView::StrView(const char* str) {
   }
 }
 
-StrView::StrView(const char* str, size_t size) {
-  if (size) {
-    assert(str != nullptr);
-    data_ = const_cast<char*>(str);
-    size_ = size;
-  }
-}
-
-bool StrView::operator==(StrView sv) const {
-  if (size_ != sv.size()) {
-    return false;
-  }
-  if (size_ == 0) {
-    return true;
-  }
-  return strncmp(data_, sv.data(), size_) == 0;
-}
-
 void StrView::assign(StrView other) {
   if (size() != other.size() || empty()) {
     return;
@@ -126,13 +226,46 @@ ComparePos StrView::compare_ci(StrView sv) const {
   return ComparePos::Greater;
 }
 
-u64 StrView::hash() const {
-  return cc::hash_fnv64(data_, size_);
+size_t StrView::find(char c) const {
+  if (empty()) {
+    return npos;
+  }
+  const char* found = find_byte(data_, data_ + size_, c);
+  return found ? size_t(found - data_) : npos;
 }
 
-size_t StrView::find(char c) const {
-  for (size_t i = 0; i < size_; i++) {
-    if (data_[i] == c) {
+size_t StrView::find_any_of(StrView chars) const {
+  if (empty() || chars.empty()) {
+    return npos;
+  }
+  if (chars.size() == 1) {
+    return find(chars[0]);
+  }
+  size_t i = 0;
+#if defined(mStrSse2)
+  if (chars.size() <= g_find_any_of_simd_max) {
+    Block needles[g_find_any_of_simd_max];
+    for (size_t j = 0; j < chars.size(); ++j) {
+      needles[j] = splat(chars[j]);
+    }
+    for (; i + g_block_size <= size_; i += g_block_size) {
+      Block block = load(data_ + i);
+      u32   mask  = 0;
+      for (size_t j = 0; j < chars.size(); ++j) {
+        mask |= eq_mask(block, needles[j]);
+      }
+      if (mask) {
+        return i + size_t(first_set_bit64(mask));
+      }
+    }
+  }
+#endif
+  bool is_delimiter[256] = {};
+  for (char c : chars) {
+    is_delimiter[u8(c)] = true;
+  }
+  for (; i < size_; ++i) {
+    if (is_delimiter[u8(data_[i])]) {
       return i;
     }
   }
@@ -155,14 +288,10 @@ size_t StrView::find(StrView term) const {
   if (term.size_ > size_) {
     return npos;
   }
-  size_t ssize = size_ - term.size_;
-  for (size_t i = 0; i <= ssize; i++) {
-    auto from_to = sub(i, term.size_);
-    if (from_to == term) {
-      return i;
-    }
+  if (term.size_ == 1) {
+    return find(term[0]);
   }
-  return npos;
+  return find_substr(data_, size_, term.data_, term.size_);
 }
 
 size_t StrView::find_last(StrView term) const {
@@ -30,24 +30,25 @@ StrBuilder::StrBuilder() {
 
 StrBuilder::~StrBuilder() noexcept {
   if (data_ != small_buffer_) {
-    free(data_);
+    str_free(data_);
   }
 }
 
-// StrBuilder::StrBuilder(StrBuilder&& other) noexcept {
-//   swap(data_, other.data_);
-//   swap(size_, other.size_);
-//   swap(capacity_, other.capacity_);
-// }
-//
-// StrBuilder& StrBuilder::operator=(StrBuilder&& other) noexcept {
-//   if (this != &other) {
-//     swap(data_, other.data_);
-//     swap(size_, other.size_);
-//     swap(capacity_, other.capacity_);
-//   }
-//   return *this;
-// }
+StrBuilder::StrBuilder(StrBuilder&& other) noexcept {
+  init();
+  take(other);
+}
+
+StrBuilder& StrBuilder::operator=(StrBuilder&& other) noexcept {
+  if (this != &other) {
+    if (data_ != small_buffer_) {
+      str_free(data_);
+    }
+    init();
+    take(other);
+  }
+  return *this;
+}
 
 void StrBuilder::appendf(const char* format, ...) {
   va_list args;
@@ -84,7 +85,8 @@ Str StrBuilder::to_string() {
   if (data_ == small_buffer_) {
     return {data_, size_};
   }
-  auto res = Str::from_raw(data_, size_);
+  // heap buffer becomes Str storage as is, builder starts over with small buffer
+  auto res = Str::from_raw(data_, size_, capacity_);
   init();
   return res;
 }
@@ -110,68 +112,91 @@ void StrBuilder::init() {
 }
 
 void StrBuilder::ensure_capacity(size_t capacity) {
-  constexpr size_t alloc_step     = 32;
-  size_t           capacity_alloc = (capacity & ~(alloc_step - 1)) + alloc_step;
-  if (capacity_alloc <= capacity_) {
+  if (capacity <= capacity_) {
     return;
   }
+  size_t capacity_alloc = mMax(capacity, capacity_ * 2);
   if (data_ == small_buffer_) {
-    data_ = (char*)malloc(capacity_alloc);
+    data_ = str_alloc(capacity_alloc);
     memcpy(data_, small_buffer_, size_);
   } else {
-    data_ = (char*)realloc(data_, capacity_alloc);
+    data_ = str_realloc(data_, capacity_alloc);
   }
   capacity_ = capacity_alloc;
 }
 
+// Takes content of other, leaves it empty. This must be in initial state.
+void StrBuilder::take(StrBuilder& other) {
+  if (other.data_ == other.small_buffer_) {
+    memcpy(small_buffer_, other.small_buffer_, other.size_);
+    size_ = other.size_;
+  } else {
+    data_     = other.data_;
+    size_     = other.size_;
+    capacity_ = other.capacity_;
+  }
+  other.init();
+}
+
+
+// is_inline() reads the tag from the last byte, top byte of Heap::capacity
+#if defined(__BYTE_ORDER__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+#endif
+static_assert(sizeof(Str) == 24);
 
 Str::~Str() {
-  str_free(data_);
+  if (!is_inline()) {
+    str_free(heap_.data);
+  }
 }
 
 Str::Str(const Str& o) {
-  if (o.size_) {
-    resize(o.size_);
-    memcpy(data_, o.data_, size_);
+  if (o.is_inline()) {
+    memcpy(inline_, o.inline_, sizeof(inline_));
+  } else if (o.heap_.size) {
+    resize(o.heap_.size);
+    memcpy(data(), o.heap_.data, o.heap_.size);
   }
 }
 
 Str& Str::operator=(const Str& o) {
   if (this != &o) {
-    resize(o.size_);
-    if (data_) memcpy(data_, o.data_, size_);
+    resize(o.size());
+    if (size_t size = this->size()) memcpy(data(), o.data(), size);
   }
   return *this;
 }
 
 Str& Str::operator=(const char* str) {
-  if (data_ != str) {
+  if (data() != str) {
     size_t size = strlen(str);
-    assert(!ptr_intersects(data_, size_, str, size));
+    assert(!ptr_intersects(data(), this->size(), str, size));
     resize(size);
-    if (data_) memcpy(data_, str, size_);
+    if (size) memcpy(data(), str, size);
   }
   return *this;
 }
 
 Str& Str::operator=(StrView str) {
-  if (data_ != str.data()) {
-    assert(!ptr_intersects(data_, size_, str.data(), str.size()));
+  if (data() != str.data()) {
+    assert(!ptr_intersects(data(), size(), str.data(), str.size()));
     resize(str.size());
-    if (data_) memcpy(data_, str.data(), size_);
+    if (!str.empty()) memcpy(data(), str.data(), str.size());
   }
   return *this;
 }
 
 Str::Str(Str&& o) noexcept {
-  swap(data_, o.data_);
-  swap(size_, o.size_);
+  memcpy(inline_, o.inline_, sizeof(inline_));
+  o.heap_ = {};
 }
 
 Str& Str::operator=(Str&& o) noexcept {
   if (this != &o) {
-    swap(data_, o.data_);
-    swap(size_, o.size_);
+    release();
+    memcpy(inline_, o.inline_, sizeof(inline_));
+    o.heap_ = {};
   }
   return *this;
 }
@@ -184,56 +209,108 @@ Str::Str(const char* str) {
   if (str != nullptr) {
     if (size_t len = strlen(str)) {
       resize(len);
-      memcpy(data_, str, size_);
+      memcpy(data(), str, len);
     }
   }
 }
 
 Str::Str(StrView str) {
-  if (str.data()) {
+  if (!str.empty()) {
     resize(str.size());
-    memcpy(data_, str.data(), size_);
+    memcpy(data(), str.data(), str.size());
   }
 }
 
 Str::Str(const char* str, size_t size) {
   if (str != nullptr && size) {
     resize(size);
-    memcpy(data_, str, size_);
+    memcpy(data(), str, size);
   }
 }
 
 Str::Str(size_t size, char ch) {
   if (size) {
     resize(size);
-    memset(data_, ch, size);
+    memset(data(), ch, size);
   }
 }
 
 Str Str::from_raw(char* data, size_t size) {
+  return from_raw(data, size, size);
+}
+
+Str Str::from_raw(char* data, size_t size, size_t capacity) {
+  assert(size <= capacity);
   Str res;
-  res.data_ = data;
-  res.size_ = size;
+  res.heap_ = {data, size, capacity};
   return res;
 }
 
 void Str::resize(size_t required_size) {
   if (required_size == 0) {
-    str_free(data_);
-    data_ = nullptr;
+    release();
+    return;
+  }
+  size_t current_capacity = capacity();
+  if (required_size > current_capacity) {
+    // exact size for new strings, geometric growth for appends
+    set_capacity(size() ? mMax(required_size, current_capacity * 2) : required_size);
+  }
+  set_size(required_size);
+}
+
+void Str::reserve(size_t capacity) {
+  if (capacity > this->capacity()) {
+    set_capacity(capacity);
+  }
+}
+
+size_t Str::capacity() const {
+  return is_inline() ? inline_capacity : heap_.capacity;
+}
+
+void Str::set_size(size_t size) {
+  if (is_inline()) {
+    inline_[inline_capacity] = char(inline_tag | size);
   } else {
-    if (size_ == 0) {
-      data_ = str_alloc(required_size);
-    } else if (required_size != size_) {
-      data_ = str_realloc(data_, required_size);
+    heap_.size = size;
+  }
+}
+
+// Moves string into storage of given capacity, which must fit it.
+void Str::set_capacity(size_t capacity) {
+  size_t size = this->size();
+  assert(capacity >= size && capacity > 0);
+  if (capacity <= inline_capacity) {
+    if (!is_inline()) {
+      char* heap = heap_.data;
+      if (size) memcpy(inline_, heap, size);
+      str_free(heap);
+      inline_[inline_capacity] = char(inline_tag | size);
     }
+    return;
+  }
+  if (is_inline()) {
+    char* heap = str_alloc(capacity);
+    memcpy(heap, inline_, size);
+    heap_.data = heap;
+    heap_.size = size;
+  } else {
+    heap_.data = str_realloc(heap_.data, capacity);
   }
-  size_ = required_size;
+  heap_.capacity = capacity;
+}
+
+void Str::release() {
+  if (!is_inline()) {
+    str_free(heap_.data);
+  }
+  heap_ = {};
 }
 
 Str& Str::null_terminate() {
-  resize(size_ + 1);
-  data_[size_ - 1] = 0;
+  resize(size() + 1);
+  data()[size() - 1] = 0;
   return *this;
 }
 
@@ -241,13 +318,10 @@ Str& Str::operator+=(StrView o) {
   if (o.empty()) {
     return *this;
   }
-  assert(!ptr_intersects(data_, size_, o.data(), o.size()));
-  if (empty()) {
-    return *this = o;
-  }
-  size_t old_size = size_;
-  resize(size() + o.size());
-  memcpy(data_ + old_size, o.data(), o.size());
+  size_t old_size = size();
+  assert(!ptr_intersects(data(), old_size, o.data(), o.size()));
+  resize(old_size + o.size());
+  memcpy(data() + old_size, o.data(), o.size());
   return *this;
 }
 
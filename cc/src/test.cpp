@@ -63,8 +63,17 @@ TestCase register_test_case(TestCase test_case) {
   return test_case;
 }
 
+void bench_report(StrView name, size_t op_count, Time elapsed) {
+  f64 ns_per_op  = op_count ? elapsed.ns() / f64(op_count) : 0.0;
+  f64 ops_per_s = elapsed.secs() > 0 ? f64(op_count) / elapsed.secs() : 0.0;
+  fprintf(stdout, "  %-40.*s %10.3f ms %10.2f ns/op %14.0f op/s\n", (int)name.size(),
+          name.data(), elapsed.ms(), ns_per_op, ops_per_s);
+  fflush(stdout);
+}
+
 int tests_main(int argc, const char** argv) {
-  Str filter;
+  Str  filter;
+  bool bench = false;
   ProgOpts::add(ProgOpts::ArgumentStr{
       .long_name     = "filter",
       .short_name    = 'f',
@@ -72,6 +81,13 @@ int tests_main(int argc, const char** argv) {
       .value         = filter,
       .flags         = ProgOpts::Optional,
   });
+  ProgOpts::add(ProgOpts::Flag{
+      .long_name     = "bench",
+      .short_name    = 'b',
+      .help_argument = "Run benchmarks instead of tests.",
+      .value         = bench,
+      .flags         = ProgOpts::Optional,
+  });
   ProgOpts::parse(argc, argv);
 
   const auto& [size, cases] = get_test_case_container();
@@ -81,8 +97,11 @@ int tests_main(int argc, const char** argv) {
   int failed = 0;
 
   for (size_t i = 0; i < size; ++i) {
-    const auto& [name, func] = cases[i];
+    const auto& [name, func, is_bench] = cases[i];
 
+    if (is_bench != bench) {
+      continue;
+    }
     if (!filter.empty() && StrView(name).find(filter) == StrView::npos) {
       continue;
     }
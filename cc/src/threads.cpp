@@ -1,42 +1,25 @@
 #include "cc/threads.hpp"
+#include "cc/arr.hpp"
 #include "cc/error.hpp"
 #include "cc/log.hpp"
 
+#include <cerrno>
+
 #if defined(_WIN32)
   #include <windows.h>
 #else
   #include <pthread.h>
+  #include <sched.h>
   #include <unistd.h>
   #include <sys/types.h>
   #ifdef __APPLE__
     #include <sys/sysctl.h>
+  #else
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
   #endif
 #endif
 
-#ifdef __clang__
-namespace {
-  int to_builtin_memory_order(MemoryOrder order) {
-    switch (order) {
-      case MemoryOrder::Relaxed:
-        return __ATOMIC_RELAXED;
-      case MemoryOrder::Consume:
-        return __ATOMIC_CONSUME;
-      case MemoryOrder::Acquire:
-        return __ATOMIC_ACQUIRE;
-      case MemoryOrder::Release:
-        return __ATOMIC_RELEASE;
-      case MemoryOrder::AcquireRelease:
-        return __ATOMIC_ACQ_REL;
-      case MemoryOrder::SequentialConsistency:
-        return __ATOMIC_SEQ_CST;
-      default:
-        return __ATOMIC_SEQ_CST;  // fallback
-    }
-  }
-}  // namespace
-#endif
-
-
 #if defined(_WIN32)
 
 DWORD WINAPI win_thread_func(LPVOID arg) {
@@ -73,6 +56,15 @@ void thread_sleep(u32 ms) {
   Sleep(ms);
 }
 
+void thread_yield() {
+  SwitchToThread();
+}
+
+// Clamped, out of range value would wrap into a wait of weeks or INFINITE one.
+DWORD to_timeout_ms(Time time) {
+  return DWORD(mClamp(ceil(time.ms()), 0.0, f64(INFINITE - 1)));
+}
+
 size_t platform_hardware_thread_count() {
   SYSTEM_INFO sys_info;
   GetSystemInfo(&sys_info);
@@ -114,6 +106,16 @@ void thread_sleep(u32 ms) {
   usleep(ms * 1000);
 }
 
+void thread_yield() {
+  sched_yield();
+}
+
+// Clamped, negative value would wrap into a wait of centuries instead of timing out.
+timespec to_timespec(Time time) {
+  u64 ns = time.ns() > 0 ? u64(time.ns()) : 0;
+  return {time_t(ns / 1'000'000'000), long(ns % 1'000'000'000)};
+}
+
 size_t platform_hardware_thread_count() {
   #ifdef __APPLE__
   int    num_threads = 2;
@@ -171,6 +173,10 @@ void Thread::sleep(Time time) {
   thread_sleep(u32(time.ms()));
 }
 
+void Thread::yield() {
+  thread_yield();
+}
+
 size_t Thread::hardware_thread_count() {
   return platform_hardware_thread_count();
 }
@@ -213,6 +219,12 @@ void ConditionVariable::wait(Mutex& mutex) {
   auto* m  = &(CRITICAL_SECTION&)mutex.data_;
   SleepConditionVariableCS(cv, m, INFINITE);
 }
+bool ConditionVariable::wait_for(Mutex& mutex, Time timeout) {
+  auto* cv = &(CONDITION_VARIABLE&)data_;
+  auto* m  = &(CRITICAL_SECTION&)mutex.data_;
+  return SleepConditionVariableCS(cv, m, to_timeout_ms(timeout)) ||
+         GetLastError() != ERROR_TIMEOUT;
+}
 void ConditionVariable::notify_one() {
   auto* cv = &(CONDITION_VARIABLE&)data_;
   WakeConditionVariable(cv);
@@ -251,8 +263,17 @@ void Mutex::unlock() {
 ConditionVariable::ConditionVariable() : data_{} {
   static_assert(sizeof(data_) >= sizeof(pthread_cond_t));
   static_assert(alignof(ConditionVariable) >= alignof(pthread_cond_t));
-  auto*                cv = &(pthread_cond_t&)data_;
-  [[maybe_unused]] int r  = pthread_cond_init(cv, nullptr);
+  auto* cv = &(pthread_cond_t&)data_;
+  #ifdef __APPLE__
+  [[maybe_unused]] int r = pthread_cond_init(cv, nullptr);
+  #else
+  // wait_for measures timeout on the same clock as Time
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  [[maybe_unused]] int r = pthread_cond_init(cv, &attr);
+  pthread_condattr_destroy(&attr);
+  #endif
   assert(r == 0);
 }
 ConditionVariable::~ConditionVariable() {
@@ -264,6 +285,24 @@ void ConditionVariable::wait(Mutex& mutex) {
   auto* m  = &(pthread_mutex_t&)mutex.data_;
   pthread_cond_wait(cv, m);
 }
+bool ConditionVariable::wait_for(Mutex& mutex, Time timeout) {
+  auto*    cv = &(pthread_cond_t&)data_;
+  auto*    m  = &(pthread_mutex_t&)mutex.data_;
+  timespec ts = to_timespec(timeout);
+  #ifdef __APPLE__
+  return pthread_cond_timedwait_relative_np(cv, m, &ts) != ETIMEDOUT;
+  #else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ts.tv_sec += now.tv_sec;
+  ts.tv_nsec += now.tv_nsec;
+  if (ts.tv_nsec >= 1'000'000'000) {
+    ts.tv_sec += 1;
+    ts.tv_nsec -= 1'000'000'000;
+  }
+  return pthread_cond_timedwait(cv, m, &ts) != ETIMEDOUT;
+  #endif
+}
 void ConditionVariable::notify_one() {
   auto* cv = &(pthread_cond_t&)data_;
   pthread_cond_signal(cv);
@@ -275,54 +314,536 @@ void ConditionVariable::notify_all() {
 
 #endif
 
-LockGuard::LockGuard(Mutex& mutex) : mutex_(mutex) {
-  mutex_.lock();
-  owns_ = true;
+#if defined(_WIN32)
+
+void futex_wait(Atomic<u32>& value, u32 expected) {
+  WaitOnAddress(&value, &expected, sizeof(expected), INFINITE);
+}
+bool futex_wait(Atomic<u32>& value, u32 expected, Time timeout) {
+  return WaitOnAddress(&value, &expected, sizeof(expected), to_timeout_ms(timeout)) ||
+         GetLastError() != ERROR_TIMEOUT;
+}
+void futex_wake_one(Atomic<u32>& value) {
+  WakeByAddressSingle(&value);
 }
-LockGuard::~LockGuard() {
-  if (owns_) {
-    mutex_.unlock();
+void futex_wake_all(Atomic<u32>& value) {
+  WakeByAddressAll(&value);
+}
+
+#elif defined(__APPLE__)
+
+// private, but stable and used by libc++ for std::atomic::wait
+extern "C" int __ulock_wait(u32 operation, void* address, u64 value, u32 timeout_us);
+extern "C" int __ulock_wake(u32 operation, void* address, u64 wake_value);
+
+namespace {
+  constexpr u32 g_ul_compare_and_wait = 1;
+  constexpr u32 g_ulf_wake_all        = 0x00000100;
+  constexpr u32 g_ulf_no_errno        = 0x01000000;
+}  // namespace
+
+void futex_wait(Atomic<u32>& value, u32 expected) {
+  __ulock_wait(g_ul_compare_and_wait | g_ulf_no_errno, &value, expected, 0);
+}
+bool futex_wait(Atomic<u32>& value, u32 expected, Time timeout) {
+  // 0 means no timeout
+  u32 timeout_us = u32(mClamp(ceil(timeout.us()), 1.0, f64(UINT32_MAX)));
+  return __ulock_wait(g_ul_compare_and_wait | g_ulf_no_errno, &value, expected,
+                      timeout_us) != -ETIMEDOUT;
+}
+void futex_wake_one(Atomic<u32>& value) {
+  __ulock_wake(g_ul_compare_and_wait | g_ulf_no_errno, &value, 0);
+}
+void futex_wake_all(Atomic<u32>& value) {
+  __ulock_wake(g_ul_compare_and_wait | g_ulf_wake_all | g_ulf_no_errno, &value, 0);
+}
+
+#else
+
+void futex_wait(Atomic<u32>& value, u32 expected) {
+  syscall(SYS_futex, &value, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+bool futex_wait(Atomic<u32>& value, u32 expected, Time timeout) {
+  timespec ts = to_timespec(timeout);
+  return syscall(SYS_futex, &value, FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0) == 0 ||
+         errno != ETIMEDOUT;
+}
+void futex_wake_one(Atomic<u32>& value) {
+  syscall(SYS_futex, &value, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+void futex_wake_all(Atomic<u32>& value) {
+  syscall(SYS_futex, &value, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#endif
+
+namespace {
+  // Spins before parking: long enough to cover short critical sections of lock owner
+  // running on other core, short compared to futex syscall round trip.
+  constexpr u32 g_lock_spin_count = 128;
+}  // namespace
+
+void AdaptiveMutex::lock_slow() {
+  for (u32 spins = 0; spins < g_lock_spin_count; ++spins) {
+    if (state_.load(MemoryOrder::Relaxed) == Unlocked && try_lock()) {
+      return;
+    }
+    cpu_relax();
+  }
+  u32 state = state_.exchange(LockedWithWaiters, MemoryOrder::Acquire);
+  while (state != Unlocked) {
+    futex_wait(state_, LockedWithWaiters);
+    state = state_.exchange(LockedWithWaiters, MemoryOrder::Acquire);
   }
 }
-void LockGuard::lock() {
-  if (!owns_) {
-    mutex_.lock();
-    owns_ = true;
+
+void RwLock::lock_slow() {
+  for (u32 spins = 0;; ++spins) {
+    u32 state = state_.load(MemoryOrder::Relaxed);
+    if ((state & (g_writer | g_readers_mask)) == 0) {
+      // also clears waiting flag, other waiting writers set it again after wake up
+      if (state_.compare_exchange_weak(state, g_writer, MemoryOrder::Acquire)) {
+        return;
+      }
+    } else if (spins < g_lock_spin_count) {
+      cpu_relax();
+    } else {
+      if ((state & g_writer_waiting) == 0) {
+        state_.fetch_or(g_writer_waiting);
+      }
+      sleep_while(g_writer | g_readers_mask);
+    }
   }
 }
-void LockGuard::unlock() {
-  if (owns_) {
-    mutex_.unlock();
-    owns_ = false;
+
+void RwLock::lock_shared_slow() {
+  for (u32 spins = 0;; ++spins) {
+    u32 state = state_.load(MemoryOrder::Relaxed);
+    if ((state & (g_writer | g_writer_waiting)) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1, MemoryOrder::Acquire)) {
+        return;
+      }
+    } else if (spins < g_lock_spin_count) {
+      cpu_relax();
+    } else {
+      sleep_while(g_writer | g_writer_waiting);
+    }
+  }
+}
+
+// Unlock changes state, then reads sleepers_ and bumps epoch_. Sleeper registers in
+// sleepers_, reads epoch_, then rechecks state, so either unlocker sees the sleeper or the
+// sleeper sees the new state; futex_wait returns at once if epoch_ has changed since.
+void RwLock::sleep_while(u32 blocking_mask) {
+  ++sleepers_;
+  u32 epoch = epoch_.load(MemoryOrder::SequentialConsistency);
+  if (state_.load(MemoryOrder::SequentialConsistency) & blocking_mask) {
+    futex_wait(epoch_, epoch);
   }
+  --sleepers_;
 }
 
-#ifdef __clang__
+namespace {
+  // Waits forever without deadline. Returns false if deadline has passed.
+  bool futex_wait_until(Atomic<u32>& value, u32 expected, const Time* deadline) {
+    if (!deadline) {
+      futex_wait(value, expected);
+      return true;
+    }
+    Time now = Time::now();
+    return now < *deadline && futex_wait(value, expected, *deadline - now);
+  }
+}  // namespace
 
-void AtomicInt::store(int v, MemoryOrder mo) {
-  __atomic_store_n(&value_, v, to_builtin_memory_order(mo));
+bool Semaphore::acquire_until(const Time* deadline) {
+  for (u32 spins = 0; spins < g_lock_spin_count; ++spins) {
+    if (try_acquire()) {
+      return true;
+    }
+    cpu_relax();
+  }
+  while (true) {
+    ++waiters_;
+    bool in_time = futex_wait_until(count_, 0, deadline);
+    --waiters_;
+    if (try_acquire()) {
+      return true;
+    }
+    if (!in_time) {
+      return false;
+    }
+  }
 }
-int AtomicInt::load(MemoryOrder mo) const {
-  return __atomic_load_n(&value_, to_builtin_memory_order(mo));
+
+bool Latch::wait_until(const Time* deadline) {
+  for (u32 spins = 0; spins < g_lock_spin_count; ++spins) {
+    if (try_wait()) {
+      return true;
+    }
+    cpu_relax();
+  }
+  // count only decreases and the last count_down() wakes everyone
+  while (true) {
+    u32 count = count_.load();
+    if (count == 0) {
+      return true;
+    }
+    if (!futex_wait_until(count_, count, deadline)) {
+      return try_wait();
+    }
+  }
 }
-int AtomicInt::fetch_add(int v, MemoryOrder mo) {
-  return __atomic_fetch_add(&value_, v, to_builtin_memory_order(mo));
+
+bool Barrier::arrive_and_wait() {
+  u32 phase = phase_.load();
+  if (arrived_.fetch_add(1, MemoryOrder::AcquireRelease) + 1 == count_) {
+    // nobody arrives for the next phase until phase_ changes
+    arrived_.store(0, MemoryOrder::Relaxed);
+    phase_.fetch_add(1, MemoryOrder::AcquireRelease);
+    futex_wake_all(phase_);
+    return true;
+  }
+  for (u32 spins = 0; spins < g_lock_spin_count && phase_.load() == phase; ++spins) {
+    cpu_relax();
+  }
+  while (phase_.load() == phase) {
+    futex_wait(phase_, phase);
+  }
+  return false;
+}
+
+bool Event::wait_until(const Time* deadline) {
+  while (true) {
+    ++waiters_;
+    bool in_time = futex_wait_until(signaled_, 0, deadline);
+    --waiters_;
+    if (try_wait()) {
+      return true;
+    }
+    if (!in_time) {
+      return false;
+    }
+  }
+}
+
+
+struct ThreadPool::Task {
+  void (*func)(void*);
+  void*     arg;
+  AtomicInt refs = 2;  // pool and handle
+  AtomicInt done = 0;
+};
+
+namespace {
+  using PoolTask = ThreadPool::Task;
+
+  void release_task(PoolTask* task) {
+    if (task->refs.fetch_sub(1) == 1) {
+      delete task;
+    }
+  }
+
+  // Chase-Lev deque ("Correct and Efficient Work-Stealing for Weak Memory Models").
+  // push/take are called only by owner, steal by any thread.
+  class WorkDeque {
+    struct Buffer {
+      s64                capacity;
+      Atomic<PoolTask*>* slots;
+      // thieves may still read previous buffers, they are freed with deque
+      Buffer* retired;
+
+      explicit Buffer(s64 cap)
+          : capacity(cap), slots(new Atomic<PoolTask*>[cap]), retired(nullptr) {}
+      ~Buffer() { delete[] slots; }
+
+      PoolTask* get(s64 i) const {
+        return slots[i & (capacity - 1)].load(MemoryOrder::Relaxed);
+      }
+      void put(s64 i, PoolTask* task) {
+        slots[i & (capacity - 1)].store(task, MemoryOrder::Relaxed);
+      }
+    };
+
+    Atomic<s64, g_cache_line_size> top_    = 0;
+    Atomic<s64, g_cache_line_size> bottom_ = 0;
+    Atomic<Buffer*>                buffer_ = new Buffer(256);
+
+   public:
+    WorkDeque() = default;
+    ~WorkDeque() {
+      Buffer* buffer = buffer_.load();
+      while (buffer) {
+        Buffer* retired = buffer->retired;
+        delete buffer;
+        buffer = retired;
+      }
+    }
+
+    WorkDeque(const WorkDeque&)            = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+
+    void push(PoolTask* task) {
+      s64     b   = bottom_.load(MemoryOrder::Relaxed);
+      s64     t   = top_.load(MemoryOrder::Acquire);
+      Buffer* buf = buffer_.load(MemoryOrder::Relaxed);
+      if (b - t > buf->capacity - 1) {
+        auto* grown = new Buffer(buf->capacity * 2);
+        for (s64 i = t; i < b; ++i) {
+          grown->put(i, buf->get(i));
+        }
+        grown->retired = buf;
+        buffer_.store(grown, MemoryOrder::Release);
+        buf = grown;
+      }
+      buf->put(b, task);
+      atomic_thread_fence(MemoryOrder::Release);
+      bottom_.store(b + 1, MemoryOrder::Relaxed);
+    }
+
+    PoolTask* take() {
+      s64     b   = bottom_.load(MemoryOrder::Relaxed) - 1;
+      Buffer* buf = buffer_.load(MemoryOrder::Relaxed);
+      bottom_.store(b, MemoryOrder::Relaxed);
+      atomic_thread_fence(MemoryOrder::SequentialConsistency);
+      s64 t = top_.load(MemoryOrder::Relaxed);
+      if (t > b) {
+        bottom_.store(b + 1, MemoryOrder::Relaxed);
+        return nullptr;
+      }
+      PoolTask* task = buf->get(b);
+      if (t == b) {
+        // last task, race with thieves
+        if (!top_.compare_exchange_strong(t, t + 1)) {
+          task = nullptr;
+        }
+        bottom_.store(b + 1, MemoryOrder::Relaxed);
+      }
+      return task;
+    }
+
+    PoolTask* steal() {
+      s64 t = top_.load(MemoryOrder::Acquire);
+      atomic_thread_fence(MemoryOrder::SequentialConsistency);
+      s64 b = bottom_.load(MemoryOrder::Acquire);
+      if (t >= b) {
+        return nullptr;
+      }
+      Buffer*   buf  = buffer_.load(MemoryOrder::Acquire);
+      PoolTask* task = buf->get(t);
+      if (!top_.compare_exchange_strong(t, t + 1)) {
+        return nullptr;
+      }
+      return task;
+    }
+  };
+
+  struct PoolWorker;
+
+  thread_local PoolWorker* t_pool_worker = nullptr;
+}  // namespace
+
+struct ThreadPool::State {
+  Arr<Thread>       threads;
+  Arr<PoolWorker*>  workers;
+  Mutex             mutex;
+  ConditionVariable work_cv;       // for idle workers
+  ConditionVariable done_cv;       // for waiters
+  Arr<Task*>        shared_queue;  // tasks submitted from outside of the pool
+  size_t            shared_head  = 0;
+  AtomicInt         shared_count = 0;
+  AtomicInt         queued       = 0;
+  AtomicInt         idle_workers = 0;
+  AtomicInt         waiters      = 0;
+  AtomicInt         stopping     = 0;
+
+  Task* find_task(PoolWorker* self);
+  void  execute(Task* task);
+  void  push(PoolWorker* self, Task* task);
+  bool  wait_for_work();
+};
+
+namespace {
+  struct PoolWorker final : ThreadFunc {
+    ThreadPool::State& pool;
+    size_t             index;
+    WorkDeque          deque;
+
+    PoolWorker(ThreadPool::State& pool, size_t index) : pool(pool), index(index) {}
+    ~PoolWorker() override = default;
+
+    const char* name() const override { return "cc-pool"; }
+
+    void run() override {
+      t_pool_worker = this;
+      while (true) {
+        if (PoolTask* task = pool.find_task(this)) {
+          pool.execute(task);
+        } else if (!pool.wait_for_work()) {
+          return;
+        }
+      }
+    }
+  };
+}  // namespace
+
+ThreadPool::Task* ThreadPool::State::find_task(PoolWorker* self) {
+  if (self) {
+    if (Task* task = self->deque.take()) {
+      --queued;
+      return task;
+    }
+  }
+
+  if (shared_count.load(MemoryOrder::Relaxed) > 0) {
+    LockGuard lock{mutex};
+    if (shared_head < shared_queue.size()) {
+      Task* task = shared_queue[shared_head++];
+      if (shared_head == shared_queue.size()) {
+        shared_queue.clear();
+        shared_head = 0;
+      }
+      --shared_count;
+      --queued;
+      return task;
+    }
+  }
+
+  size_t start = self ? self->index + 1 : 0;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    PoolWorker* victim = workers[(start + i) % workers.size()];
+    if (victim == self) {
+      continue;
+    }
+    if (Task* task = victim->deque.steal()) {
+      --queued;
+      return task;
+    }
+  }
+  return nullptr;
 }
-int AtomicInt::fetch_sub(int v, MemoryOrder mo) {
-  return __atomic_fetch_sub(&value_, v, to_builtin_memory_order(mo));
+
+void ThreadPool::State::execute(Task* task) {
+  try {
+    task->func(task->arg);
+  } catch (const Err& err) {
+    mLogWarn("Thread pool task failed: ", err.message());
+  } catch (...) {
+    mLogWarn("Thread pool task failed with unknown exception");
+  }
+  task->done.store(1, MemoryOrder::SequentialConsistency);
+  if (waiters.load(MemoryOrder::SequentialConsistency) > 0) {
+    LockGuard lock{mutex};
+    done_cv.notify_all();
+  }
+  release_task(task);
 }
-bool AtomicInt::compare_exchange_strong(int& expected, int desired, MemoryOrder mo) {
-  return __atomic_compare_exchange_n(&value_, &expected, desired,
-                                     /*weak=*/false, to_builtin_memory_order(mo),
-                                     to_builtin_memory_order(mo));
+
+void ThreadPool::State::push(PoolWorker* self, Task* task) {
+  // counted before task is published, so a thief can not drive it below zero
+  ++queued;
+  if (self) {
+    self->deque.push(task);
+  } else {
+    LockGuard lock{mutex};
+    shared_queue.push(task);
+    ++shared_count;
+  }
+  if (idle_workers.load(MemoryOrder::SequentialConsistency) > 0 ||
+      waiters.load(MemoryOrder::SequentialConsistency) > 0) {
+    LockGuard lock{mutex};
+    work_cv.notify_one();
+    done_cv.notify_all();
+  }
 }
-AtomicInt& AtomicInt::operator++() {
-  fetch_add(1);
-  return *this;
+
+// Returns false only when pool is stopping and no work is left.
+bool ThreadPool::State::wait_for_work() {
+  LockGuard lock{mutex};
+  ++idle_workers;
+  while (queued.load(MemoryOrder::SequentialConsistency) == 0 && stopping.load() == 0) {
+    work_cv.wait(mutex);
+  }
+  --idle_workers;
+  return stopping.load() == 0 || queued.load() > 0;
 }
-AtomicInt& AtomicInt::operator--() {
-  fetch_sub(1);
+
+ThreadPool::TaskHandle& ThreadPool::TaskHandle::operator=(TaskHandle&& other) noexcept {
+  if (this != &other) {
+    swap(task_, other.task_);
+  }
   return *this;
 }
 
-#endif
+ThreadPool::TaskHandle::~TaskHandle() {
+  if (task_) {
+    release_task(task_);
+  }
+}
+
+bool ThreadPool::TaskHandle::is_done() const {
+  return task_ && task_->done.load() != 0;
+}
+
+ThreadPool::ThreadPool(size_t workers_count) : state_(new State) {
+  state_->workers.reserve(workers_count);
+  state_->threads.reserve(workers_count);
+  for (size_t i = 0; i < workers_count; ++i) {
+    state_->workers.push(new PoolWorker(*state_, i));
+  }
+  for (PoolWorker* worker : state_->workers) {
+    state_->threads.emplace(UPtr<ThreadFunc>(worker));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    LockGuard lock{state_->mutex};
+    state_->stopping.store(1);
+    state_->work_cv.notify_all();
+  }
+  // workers steal from each other until exit, destroy them after all are joined
+  Arr<UPtr<ThreadFunc>> workers;
+  for (auto& thread : state_->threads) {
+    workers.push(thread.join());
+  }
+}
+
+ThreadPool& ThreadPool::global() {
+  static ThreadPool pool(mMax(Thread::hardware_thread_count(), size_t(2)) - 1);
+  return pool;
+}
+
+size_t ThreadPool::workers_count() const {
+  return state_->workers.size();
+}
+
+ThreadPool::TaskHandle ThreadPool::submit(void (*func)(void*), void* arg) {
+  auto*       task = new Task{func, arg};
+  PoolWorker* self = t_pool_worker && &t_pool_worker->pool == state_.get() ? t_pool_worker
+                                                                            : nullptr;
+  state_->push(self, task);
+  return TaskHandle(task);
+}
+
+void ThreadPool::wait(TaskHandle& handle) {
+  Task* task = handle.task_;
+  if (!task) {
+    return;
+  }
+  PoolWorker* self = t_pool_worker && &t_pool_worker->pool == state_.get() ? t_pool_worker
+                                                                            : nullptr;
+  while (task->done.load() == 0) {
+    if (Task* other = state_->find_task(self)) {
+      state_->execute(other);
+      continue;
+    }
+    LockGuard lock{state_->mutex};
+    ++state_->waiters;
+    while (task->done.load(MemoryOrder::SequentialConsistency) == 0 &&
+           state_->queued.load(MemoryOrder::SequentialConsistency) == 0) {
+      state_->done_cv.wait(state_->mutex);
+    }
+    --state_->waiters;
+  }
+  handle = TaskHandle();
+}
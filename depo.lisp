@@ -3,7 +3,7 @@
   (files cc/*.cpp cc/*.c)
   (include 'pub cc/inc)
   (include cc/src)
-  (link 'pub 'sys 'win Shell32.lib)
+  (link 'pub 'sys 'win Shell32.lib Synchronization.lib)
 )
 
 (project cc-tests